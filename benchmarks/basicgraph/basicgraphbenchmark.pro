@@ -0,0 +1,22 @@
+# Benchmarks of QtBasicGraph. The project is built on its own and runs
+# headless on the offscreen platform:
+#
+#   qmake && make
+#   ./qtbasicgraphbenchmark -o results.csv,csv
+#
+# Without an output option the results are printed as CSV.
+
+TEMPLATE = app
+TARGET = qtbasicgraphbenchmark
+
+QT += core \
+    gui \
+    widgets \
+    testlib
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../src/basicgraph/basicgraph.pri)
+
+SOURCES += qtbasicgraphbenchmark.cpp
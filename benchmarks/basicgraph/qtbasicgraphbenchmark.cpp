@@ -0,0 +1,408 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Benchmarks of ingestion, painting and memory use of QtBasicGraph.
+#include "qtbasicgraph.h"
+#include "qtbasicgraphhistory.h"
+#include "qtbasicgraphfilehistory.h"
+#include "qtbasicgraphcompressedhistory.h"
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QFileInfo>
+#include <QImage>
+
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#elif defined(Q_OS_MAC)
+#  include <malloc/malloc.h>
+#endif
+
+namespace {
+
+enum Path {
+    AddPoint,
+    AddSample,
+    AddSamples
+};
+
+enum Storage {
+    LiveOnly,
+    MemoryHistory,
+    CompressedHistory,
+    FileHistory
+};
+
+enum Mode {
+    PlainMode,
+    LayeredMode,
+    ThreadedMode,
+    PersistenceMode
+};
+
+enum {
+    IngestCount = 100000,     // points added per benchmark iteration
+    BlockSize = 1024,         // points per addSamples() call
+    MemoryCount = 1000000,    // points added for the memory measurement
+    FrameSteps = 100          // frames that scroll the view by its width
+};
+
+const char *storageName(int storage)
+{
+    switch (storage) {
+    case MemoryHistory:     return "memory history";
+    case CompressedHistory: return "compressed history";
+    case FileHistory:       return "file history";
+    default:                return "live";
+    }
+}
+
+QtBasicGraphHistory *createHistory(int storage)
+{
+    switch (storage) {
+    case MemoryHistory:     return new QtBasicGraphMemoryHistory;
+    case CompressedHistory: return new QtBasicGraphCompressedHistory;
+    case FileHistory:       return new QtBasicGraphFileHistory;
+    default:                return 0;
+    }
+}
+
+// a slow sine with some fast ripple, so decimation and compression see
+// realistic data instead of a constant
+float sampleValue(qint64 index)
+{
+    return float(std::sin(index * 0.001) + 0.1 * std::sin(index * 0.37));
+}
+
+// adds the points with the running numbers first to first + count - 1
+void addData(QtBasicGraph *graph, int path, qint64 first, int count)
+{
+    if (path == AddPoint) {
+        for (qint64 i = first; i < first + count; ++i)
+            graph->addPoint(QPointF(i, sampleValue(i)));
+    } else if (path == AddSample) {
+        for (qint64 i = first; i < first + count; ++i)
+            graph->addSample(sampleValue(i));
+    } else {
+        float block[BlockSize];
+        for (int done = 0; done < count; ) {
+            const int n = qMin(int(BlockSize), count - done);
+            for (int i = 0; i < n; ++i)
+                block[i] = sampleValue(first + done + i);
+            graph->addSamples(block, n);
+            done += n;
+        }
+    }
+}
+
+const char *modeName(int mode)
+{
+    switch (mode) {
+    case LayeredMode:     return "layered";
+    case ThreadedMode:    return "threaded";
+    case PersistenceMode: return "persistence";
+    default:              return "plain";
+    }
+}
+
+// bytes currently allocated from the heap by the whole process, including
+// the growth slack of containers and the allocator's own headers, or -1 if
+// the C library does not tell; memory mapped files are not included
+qint64 heapBytes()
+{
+#if defined(__GLIBC__)
+#  if __GLIBC_PREREQ(2, 33)
+    const struct mallinfo2 info = mallinfo2();
+#  else
+    const struct mallinfo info = mallinfo();
+#  endif
+    return qint64(info.uordblks) + qint64(info.hblkhd);
+#elif defined(Q_OS_MAC)
+    malloc_statistics_t stats;
+    malloc_zone_statistics(0, &stats);
+    return qint64(stats.size_in_use);
+#else
+    return -1;
+#endif
+}
+
+// creates a graph for the memory measurements and adds MemoryCount samples;
+// without a history all samples stay in the live window, with a history
+// the live window is kept small so the history dominates
+void fillGraph(QtBasicGraph *graph, bool fixedRate, int storage)
+{
+    if (fixedRate)
+        graph->setSampleInterval(1);
+    graph->setXRange(storage == LiveOnly ? MemoryCount : 1000);
+    graph->setHistory(createHistory(storage));
+
+    addData(graph, fixedRate ? AddSamples : AddPoint, 0, MemoryCount);
+}
+
+} // namespace
+
+
+class QtBasicGraphBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void ingestion_data();
+    void ingestion();
+    void paint_data();
+    void paint();
+    void frame_data();
+    void frame();
+    void memory_data();
+    void memory();
+    void fileStorage_data();
+    void fileStorage();
+};
+
+void QtBasicGraphBenchmark::ingestion_data()
+{
+    QTest::addColumn<int>("path");
+    QTest::addColumn<int>("storage");
+
+    const char *paths[] = { "addPoint", "addSample", "addSamples" };
+
+    for (int path = AddPoint; path <= AddSamples; ++path) {
+        for (int storage = LiveOnly; storage <= FileHistory; ++storage) {
+            const QByteArray tag = QByteArray(paths[path]) + ' ' + storageName(storage);
+            QTest::newRow(tag.constData()) << path << storage;
+        }
+    }
+}
+
+/*
+    Time to add IngestCount points through the given path to a graph with
+    a live window of 10000 points, points/s = IngestCount / time.
+*/
+void QtBasicGraphBenchmark::ingestion()
+{
+    QFETCH(int, path);
+    QFETCH(int, storage);
+
+    QtBasicGraph graph(0);
+    graph.resize(800, 480);
+    if (path != AddPoint)
+        graph.setSampleInterval(1);
+    graph.setXRange(10000);
+    graph.setHistory(createHistory(storage));
+
+    qint64 first = 0;
+    QBENCHMARK {
+        addData(&graph, path, first, IngestCount);
+        first += IngestCount;
+    }
+}
+
+void QtBasicGraphBenchmark::paint_data()
+{
+    QTest::addColumn<bool>("fixedRate");
+    QTest::addColumn<int>("visible");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("antialiasing");
+    QTest::addColumn<bool>("fastRaster");
+
+    const int counts[] = { 1000, 100000, 1000000 };
+    const QSize sizes[] = { QSize(320, 240), QSize(800, 480), QSize(1920, 1080) };
+
+    for (int mode = 0; mode < 2; ++mode) {
+        for (int c = 0; c < 3; ++c) {
+            for (int s = 0; s < 3; ++s) {
+                for (int style = 0; style < 3; ++style) {
+                    const char *styles[] = { "aliased", "antialiased", "fast raster" };
+                    const QByteArray tag = QByteArray(mode ? "fixed-rate " : "irregular ")
+                                           + QByteArray::number(counts[c]) + ' '
+                                           + QByteArray::number(sizes[s].width()) + 'x'
+                                           + QByteArray::number(sizes[s].height()) + ' ' + styles[style];
+                    QTest::newRow(tag.constData()) << bool(mode) << counts[c] << sizes[s]
+                                                   << (style == 1) << (style == 2);
+                }
+            }
+        }
+    }
+}
+
+/*
+    Time of one full paintEvent() with the given number of visible samples.
+*/
+void QtBasicGraphBenchmark::paint()
+{
+    QFETCH(bool, fixedRate);
+    QFETCH(int, visible);
+    QFETCH(QSize, size);
+    QFETCH(bool, antialiasing);
+    QFETCH(bool, fastRaster);
+
+    QtBasicGraph graph(0);
+    graph.resize(size);
+    graph.setYMinMax(-1.2, 1.2);
+    if (antialiasing)
+        graph.setRenderHints(QPainter::Antialiasing);
+    graph.setFastRasterization(fastRaster);
+    if (fixedRate)
+        graph.setSampleInterval(1);
+    graph.setXRange(visible - 1);
+
+    addData(&graph, fixedRate ? AddSamples : AddPoint, 0, visible);
+    QVERIFY(graph.sampleCount() >= visible - 1);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        graph.render(&image);
+    }
+}
+
+void QtBasicGraphBenchmark::frame_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("visible");
+
+    const int counts[] = { 10000, 1000000 };
+
+    for (int mode = PlainMode; mode <= PersistenceMode; ++mode) {
+        for (int c = 0; c < 2; ++c) {
+            const QByteArray tag = QByteArray(modeName(mode)) + ' ' + QByteArray::number(counts[c]);
+            QTest::newRow(tag.constData()) << mode << counts[c];
+        }
+    }
+}
+
+/*
+    Time of one frame of a shown 800x480 graph that follows fixed-rate
+    samples: the samples scrolling the view by a hundredth of its width are
+    added and the widget is repainted. The layered mode shows the grid and
+    the crosshair, the persistence mode the density image. With threaded
+    rendering this is the time spent in the GUI thread; the finished images
+    of the render jobs are delivered with the events of the next frame.
+*/
+void QtBasicGraphBenchmark::frame()
+{
+    QFETCH(int, mode);
+    QFETCH(int, visible);
+
+    QtBasicGraph graph(0);
+    graph.resize(800, 480);
+    graph.setYMinMax(-1.2, 1.2);
+    graph.setSampleInterval(1);
+    graph.setXRange(visible);
+    graph.setGridVisible(mode == LayeredMode);
+    graph.setCrosshairEnabled(mode == LayeredMode);
+    graph.setThreadedRendering(mode == ThreadedMode);
+    graph.setPersistence(mode == PersistenceMode);
+
+    addData(&graph, AddSamples, 0, visible);
+    graph.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&graph));
+
+    const int step = visible / FrameSteps;
+    qint64 first = visible;
+    QBENCHMARK {
+        addData(&graph, AddSamples, first, step);
+        first += step;
+        graph.repaint();
+        QCoreApplication::processEvents();
+    }
+}
+
+void QtBasicGraphBenchmark::memory_data()
+{
+    QTest::addColumn<bool>("fixedRate");
+    QTest::addColumn<int>("storage");
+
+    for (int mode = 0; mode < 2; ++mode) {
+        for (int storage = LiveOnly; storage <= FileHistory; ++storage) {
+            const QByteArray tag = QByteArray(mode ? "fixed-rate " : "irregular ") + storageName(storage);
+            QTest::newRow(tag.constData()) << bool(mode) << storage;
+        }
+    }
+}
+
+/*
+    Heap bytes per sample the graph allocated while MemoryCount samples
+    were added, measured from the allocation statistics of the C library
+    before and after, so the growth slack of the containers counts. The
+    file history's mapped file is not on the heap, see fileStorage().
+*/
+void QtBasicGraphBenchmark::memory()
+{
+    QFETCH(bool, fixedRate);
+    QFETCH(int, storage);
+
+    const qint64 before = heapBytes();
+    if (before < 0)
+        QSKIP("The C library does not report heap statistics");
+
+    QtBasicGraph graph(0);
+    graph.resize(800, 480);
+    fillGraph(&graph, fixedRate, storage);
+
+    QTest::setBenchmarkResult(qreal(heapBytes() - before) / MemoryCount, QTest::BytesAllocated);
+}
+
+void QtBasicGraphBenchmark::fileStorage_data()
+{
+    QTest::addColumn<bool>("fixedRate");
+
+    QTest::newRow("irregular file history") << false;
+    QTest::newRow("fixed-rate file history") << true;
+}
+
+/*
+    Bytes per sample of the file a file history wrote for MemoryCount
+    samples. All of its chunks are mapped, so this is also the address
+    space the mappings take; how much of it is resident is up to the
+    operating system.
+*/
+void QtBasicGraphBenchmark::fileStorage()
+{
+    QFETCH(bool, fixedRate);
+
+    QtBasicGraph graph(0);
+    graph.resize(800, 480);
+    fillGraph(&graph, fixedRate, FileHistory);
+
+    const QtBasicGraphFileHistory *history = static_cast<const QtBasicGraphFileHistory *>(graph.history());
+    QVERIFY(history->isOpen());
+
+    QTest::setBenchmarkResult(qreal(QFileInfo(history->fileName()).size()) / MemoryCount,
+                              QTest::BytesAllocated);
+}
+
+
+int main(int argc, char *argv[])
+{
+    // headless by default, an explicit platform still wins
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    // write machine-readable results unless an output format was given
+    QStringList arguments = app.arguments();
+    bool output = false;
+    foreach (const QString &argument, arguments) {
+        if (argument == QLatin1String("-o") || argument == QLatin1String("-csv")
+            || argument == QLatin1String("-txt") || argument == QLatin1String("-xml")
+            || argument == QLatin1String("-lightxml") || argument == QLatin1String("-xunitxml")
+            || argument == QLatin1String("-teamcity") || argument == QLatin1String("-tap"))
+            output = true;
+    }
+    if (!output)
+        arguments << QLatin1String("-csv");
+
+    QtBasicGraphBenchmark benchmark;
+    return QTest::qExec(&benchmark, arguments);
+}
+
+#include "qtbasicgraphbenchmark.moc"
@@ -6,10 +6,14 @@ QT += core \
     gui \
     svg
 
-greaterThan(QT_MAJOR_VERSION, 4) {
-    QT += widgets
+# the widgets use the Qt 5 screen, input and high DPI APIs and C++11
+lessThan(QT_MAJOR_VERSION, 5) | if(equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 6)) {
+    error("embedded-widgets requires Qt 5.6 or later")
 }
 
+QT += widgets
+CONFIG += c++11
+
 TEMPLATE = lib
 TARGET = $$uslQtLibraryTarget(embedded-widgets, d)
 INCLUDEPATH += .
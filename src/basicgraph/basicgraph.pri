@@ -1,6 +1,25 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
-SOURCES += $$PWD/qtbasicgraph.cpp
-HEADERS += $$PWD/qtbasicgraph.h
+SOURCES += $$PWD/qtbasicgraph.cpp \
+           $$PWD/qtbasicgraphingestion.cpp \
+           $$PWD/qtbasicgraphtrigger.cpp \
+           $$PWD/qtbasicgraphstatistics.cpp \
+           $$PWD/qtbasicgraphpersistence.cpp \
+           $$PWD/qtbasicgraphthreading.cpp \
+           $$PWD/qtbasicgraphreadout.cpp \
+           $$PWD/qtbasicgraphraster.cpp \
+           $$PWD/qtbasicgraphannotations.cpp \
+           $$PWD/qtbasicgraphhistory.cpp \
+           $$PWD/qtbasicgraphfilehistory.cpp \
+           $$PWD/qtbasicgraphcompressedhistory.cpp \
+           $$PWD/qtbasicgraphkernels.cpp \
+           $$PWD/qtbasicgraphmodelsource.cpp
+HEADERS += $$PWD/qtbasicgraph.h \
+           $$PWD/qtbasicgraphannotations.h \
+           $$PWD/qtbasicgraphhistory.h \
+           $$PWD/qtbasicgraphfilehistory.h \
+           $$PWD/qtbasicgraphcompressedhistory.h \
+           $$PWD/qtbasicgraphkernels.h \
+           $$PWD/qtbasicgraphmodelsource.h
 
 QT += svg
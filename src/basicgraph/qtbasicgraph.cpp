@@ -7,12 +7,19 @@
 */
 
 #include "qtbasicgraph.h"
+#include "qtbasicgraphannotations.h"
+#include "qtbasicgraphhistory.h"
+#include "qtbasicgraphmodelsource.h"
 #include <QtCore/QDebug>
+#include <QtCore/QThreadPool>
 #include <QStandardItemModel>
 #include <QtGui>
 
 #include <QDebug>
 
+#include <cmath>
+#include <cstring>
+
 /*!
 
     \class QtBasicGraph qtbasicgraph.h
@@ -24,6 +31,98 @@
     The QtBasicGraph is an example to show the capabilities of the Qt Framework related
     to customized controls.
 
+    Points with arbitrary x values are added with addPoint(). For channels that
+    are sampled at a fixed rate call setSampleInterval() first; the graph then
+    stores only the y values as floats and derives the x value of every sample
+    from its index. New samples are added with addSample() or addSamples().
+
+    By default only the data of the last xRange() is kept. To zoom out and
+    pan over older data install a QtBasicGraphHistory with setHistory(). The
+    mouse wheel then zooms the view and dragging pans it; as long as the
+    right edge of the view is the newest sample the graph keeps following
+    the incoming data. A double click returns to the live view.
+
+    On devices where QPainter line drawing is the bottleneck
+    setFastRasterization() lets the graph draw the trace itself: as long as
+    antialiasing is not enabled with setRenderHints() the 1 pixel wide trace
+    is written directly into an image with an integer line algorithm, which
+    fills all pixels of a line within one column as a single vertical span.
+
+    setRenderStyle() draws the trace as steps, as scatter markers or as a
+    filled area instead of a line. All styles work on the same decimated
+    trace, so their cost does not grow with the number of samples either:
+    steps are drawn as a single polyline, the markers are blitted from a
+    cached sprite and the area is filled from the range of every pixel
+    column. The scatter markers are only at the exact sample positions
+    while there are at most 4 samples per pixel column. Beyond that, every
+    column shows markers at its first, minimum, maximum and last value, all
+    at the center of the column.
+
+    With setAutoRange() the y range follows the minimum and maximum of the
+    live window. Both are tracked with monotonic queues at amortized O(1) per
+    sample. The range is only changed, and the graph only fully repainted,
+    when the data leaves the current range or fills less of it than the
+    hysteresis allows.
+
+    setStatisticsEnabled() keeps the mean, standard deviation, minimum and
+    maximum of the live window up to date while samples are added and
+    purged, at amortized O(1) per sample. statisticsChanged() reports them
+    at most once per frame, however fast the samples arrive.
+
+    setGridVisible() and setCrosshairEnabled() switch the graph to layered
+    compositing. The vertical grid lines are fixed to the data, so the grid
+    layer scrolls along with the trace and is only rebuilt when the size or
+    one of the ranges changes. The trace is kept in a transparent layer of
+    its own. New data scrolls both layers and the widget in place, and only
+    the uncovered strip, the labels of the y axis and the crosshair are
+    painted again. The crosshair and the value of the nearest sample are
+    drawn on top while composing, so moving the mouse only repaints the old
+    and new overlay.
+    nearestSample() finds the sample under any widget position for own
+    tooltips or cursors.
+
+    Events are annotated with addMarker() and addSpan(). The annotations
+    are kept in an interval index, see QtBasicGraphAnnotations, so a paint
+    only looks at the ones in the view even with tens of thousands of
+    events. They are purged together with the data of the live window.
+
+    Instead of adding the data the graph can show the rows of a
+    QAbstractItemModel, see setModel(). Every y column becomes a trace of its
+    own. Rows inserted, removed or changed in the model only repaint the
+    affected part of the view, rows appended while the graph follows the
+    data scroll it like addPoint() does. Several graphs can share the data
+    of one model with setModelSource().
+
+    With setTrigger() the graph works like an oscilloscope. The incoming
+    samples are searched for the trigger level being crossed in the chosen
+    direction and the view range around the crossing is shown, with
+    triggerPosition() of it before the crossing. The capture is shown as
+    soon as the samples after the crossing have arrived and then stays until
+    the next trigger, or until armTrigger() is called in single shot mode.
+    The samples before the crossing are taken from the live window, which is
+    why the view range should be smaller than xRange(); a capture is only
+    copied once its samples are about to be purged.
+
+    For noisy signals sampled much faster than the screen resolution
+    setPersistence() draws a density image instead of a line, like a
+    digital phosphor oscilloscope: every line of the decimated trace adds
+    a hit to the pixels it covers and the number of hits is mapped to a
+    color. Only the columns uncovered by scrolling are traced, so the
+    tracing cost per frame stays proportional to the new samples. With
+    every frame the intensity decays, so older data fades out behind the
+    newest samples, and in triggered mode every new capture is added to the
+    decayed intensity of the ones before. The decay is a single factor for
+    the whole image, and the colors of the older columns are brought up to
+    date one band per frame.
+
+    With setThreadedRendering() the trace is rendered on a worker thread.
+    The graph only hands the job a snapshot of the view and references to
+    its implicitly shared sample arrays; the job traces and decimates the
+    samples and draws them into an image, and paintEvent() just composes
+    the last finished image. New data arriving while a job runs is rendered
+    by the next job from a fresh snapshot, so a busy graph drops frames
+    instead of blocking the user interface.
+
 */
 /*!
     Constructor of the QtBasicGraph.
@@ -31,7 +130,21 @@
 */
 QtBasicGraph::QtBasicGraph(QWidget * parent)
     : QWidget(parent),
-    m_ymin(-1), m_ymax(1), m_xrange(1), m_scroll_error(0), m_render_hints(0)
+    m_ymin(-1), m_ymax(1), m_xrange(1), m_scroll_error(0), m_render_hints(0), m_fast_raster(false),
+    m_render_style(Lines), m_sprite_dpr(0),
+    m_value_offset(0), m_purged_values(0), m_sample_offset(0), m_first_sample(0), m_origin_x(0), m_sample_interval(0),
+    m_history(0), m_view_range(1), m_view_right(0), m_follow(true), m_drag_start_right(0), m_source_first(0),
+    m_source_removed(0),
+    m_auto_range(false), m_auto_range_hysteresis(0.1),
+    m_statistics(false), m_stats_count(0), m_stats_mean(0), m_stats_m2(0),
+    m_grid(false), m_grid_dirty(true), m_grid_label_width(0), m_crosshair(false), m_crosshair_visible(false),
+    m_trigger_mode(NoTrigger), m_trigger_level(0), m_trigger_position(0.5), m_trigger_single(false),
+    m_trigger_armed(false), m_trigger_pending(false), m_trigger_x(0), m_trigger_serial(0),
+    m_capture_valid(false), m_capture_right(0), m_capture_fresh(false),
+    m_persistence(false), m_persistence_decay(0.8), m_persistence_saturation(16), m_persistence_custom_colors(false),
+    m_persistence_scale(1), m_persistence_next_band(0),
+    m_threaded(false), m_render_running(false), m_render_pending(false), m_render_generation(0),
+    m_render_stale(0), m_render_pool(0)
 {
     setAttribute(Qt::WA_OpaquePaintEvent);
 }
@@ -41,134 +154,777 @@ QtBasicGraph::QtBasicGraph(QWidget * parent)
 */
 QtBasicGraph::~QtBasicGraph()
 {
+    // waits for a running render job
+    delete m_render_pool;
+    delete m_history;
 }
 
+/*!
+    Sets the visible y range from \a ymin to \a ymax and switches off the
+    auto range.
+*/
 void QtBasicGraph::setYMinMax(qreal ymin, qreal ymax)
 {
+    m_auto_range = false;
     m_ymin = ymin;
     m_ymax = ymax;
     m_scroll_error = 0;
-    update();
+    invalidate();
+    emit yRangeChanged(m_ymin, m_ymax);
 }
 
 void QtBasicGraph::setXRange(qreal xrange)
 {
     m_xrange = xrange;
+    m_view_range = xrange;
+    if (m_source)
+        rebuildSource();
     m_scroll_error = 0;
-    update();
+    invalidate();
 }
 
 void QtBasicGraph::setRenderHints(QPainter::RenderHints hints)
 {
     m_render_hints = hints;
     m_scroll_error = 0;
-    update();
+    invalidate();
 }
 
 
-void QtBasicGraph::addPoint(const QPointF &value)
+/*!
+    Sets the \a style the traces are drawn in. The default is Lines.
+*/
+void QtBasicGraph::setRenderStyle(RenderStyle style)
 {
-    QPointF oldval;
+    m_render_style = style;
+    updateSprites();
+    m_scroll_error = 0;
+    invalidate();
+}
 
-    if (!m_values.isEmpty())
-        oldval = m_values.last();
+/*!
+    Enables or disables drawing the trace directly into an image instead of
+    using QPainter. The fast path is only used while antialiasing is off.
+*/
+void QtBasicGraph::setFastRasterization(bool enabled)
+{
+    m_fast_raster = enabled;
+    if (!enabled)
+        m_raster = QImage();
+    m_scroll_error = 0;
+    invalidate();
+}
 
-    if (!oldval.isNull() && value.x() < oldval.x()) {
-        qWarning("QtBasicGraph::addPoint(): the new point's x value is less than the last point's x value.");
-        return; 
-    }
+/*!
+    Switches the graph to fixed-rate mode with samples \a interval apart.
+    An \a interval of 0 switches back to irregular x/y points.
+    All data currently held by the graph is discarded.
+*/
+void QtBasicGraph::setSampleInterval(qreal interval)
+{
+    if (interval < 0)
+        interval = 0;
 
-    m_values << value;
+    m_sample_interval = interval;
+    clear();
+}
 
-    if (!oldval.isNull()) {
-        qreal deltaf = width() * ((value.x() - oldval.x()) / m_xrange);
-        int delta = (int) deltaf;
-        m_scroll_error += (deltaf - qreal(delta));
+/*!
+    Installs \a history as long term storage for all samples added from now
+    on. The graph takes ownership of \a history and deletes the previous one.
+    Passing 0 removes the history and returns to the live view.
+*/
+void QtBasicGraph::setHistory(QtBasicGraphHistory *history)
+{
+    if (history == m_history)
+        return;
 
-        if (m_scroll_error > qreal(1.0)) {
-            m_scroll_error--;
-            delta++;
-        }
+    delete m_history;
+    m_history = history;
+    resetView();
+}
 
-        if (delta < width()) {
-            scroll(-delta, 0);
-            update(width() - delta - 3, 0, delta + 3, height());
-        } else {
-            m_scroll_error = 0;
-            update();
-        }
+/*!
+    Sets the visible x range to \a range. Ranges larger than xRange() are
+    only shown if a history is installed.
+*/
+void QtBasicGraph::setViewRange(qreal range)
+{
+    if (range <= 0)
+        return;
 
-        // purge old data
-        qreal left = value.x() - m_xrange;
+    m_view_range = range;
+    m_scroll_error = 0;
+    invalidate();
+}
 
-        int i;
-        for (i = 0; i < m_values.size(); ++i) {
-            if (m_values[i].x() > left)
-                break;
-        }
-        i--;
-        
-        if (i > 0 && i < (m_values.size() - 1))
-            m_values.erase(m_values.begin(), m_values.begin() + i);
-  
-  }
+/*!
+    Returns to the live view of the last xRange().
+*/
+void QtBasicGraph::resetView()
+{
+    m_view_range = m_xrange;
+    m_follow = true;
+    m_scroll_error = 0;
+    invalidate();
 }
 
-void QtBasicGraph::clear()
+/*!
+    Shows or hides a grid with labels of the y and x values. The grid is
+    cached and scrolled with the data, it is only rendered again when the
+    size or the range of the graph changes.
+*/
+void QtBasicGraph::setGridVisible(bool visible)
 {
-    m_values.clear();
+    m_grid = visible;
     m_scroll_error = 0;
+    invalidate();
+}
+
+/*!
+    Adds a vertical marker at \a x labeled with \a text. An invalid
+    \a color draws the marker in the highlight color of the palette.
+*/
+void QtBasicGraph::addMarker(qreal x, const QString &text, const QColor &color)
+{
+    addSpan(x, x, text, color);
+}
+
+/*!
+    Adds a shaded span from \a start to \a end labeled with \a text. An
+    invalid \a color draws the span in the highlight color of the palette.
+*/
+void QtBasicGraph::addSpan(qreal start, qreal end, const QString &text, const QColor &color)
+{
+    QtBasicGraphAnnotations::Annotation annotation;
+    annotation.start = qMin(start, end);
+    annotation.end = qMax(start, end);
+    annotation.text = text;
+    annotation.color = color;
+    m_annotations.add(annotation);
+
+    const qreal right = viewRight();
+    if (annotation.end >= right - m_view_range && annotation.start <= right)
+        update();
+}
+
+/*!
+    Removes all markers and spans.
+*/
+void QtBasicGraph::clearAnnotations()
+{
+    m_annotations.clear();
     update();
 }
 
+/*!
+    Shows the rows of \a model, with the x values in column \a xColumn and
+    one trace for each column in \a yColumns. The x values have to be in
+    ascending order. The graph owns the source created for the model; it can
+    be shared with other graphs through modelSource() and setModelSource().
+    Passing 0 returns to the data added with addPoint().
+
+    The rows of the last xRange() feed the auto range, the statistics and
+    the trigger like the data added with addPoint(). The auto range covers
+    all traces, the statistics and the trigger use the first one. Appended
+    rows and rows removed from the front, as in a model that streams its
+    data through a fixed number of rows, update them incrementally; other
+    changes within the live window fill them again from all of its rows.
+*/
+void QtBasicGraph::setModel(QAbstractItemModel *model, int xColumn, const QList<int> &yColumns)
+{
+    setModelSource(model ? new QtBasicGraphModelSource(model, xColumn, yColumns, this) : 0);
+}
+
+/*!
+    Shows the data of \a source, which may be shared with other graphs.
+    The graph only takes ownership of sources created by setModel().
+*/
+void QtBasicGraph::setModelSource(QtBasicGraphModelSource *source)
+{
+    if (source == m_source)
+        return;
+
+    if (m_source) {
+        disconnect(m_source, 0, this, 0);
+        if (m_source->parent() == this)
+            delete m_source;
+    }
+
+    m_source = source;
+
+    if (m_source) {
+        connect(m_source, SIGNAL(pointsInserted(int,int)), this, SLOT(sourceInserted(int,int)));
+        connect(m_source, SIGNAL(pointsAboutToBeRemoved(int,int)), this, SLOT(sourceAboutToBeRemoved(int,int)));
+        connect(m_source, SIGNAL(pointsRemoved(int,int)), this, SLOT(sourceRemoved(int,int)));
+        connect(m_source, SIGNAL(pointsChanged(int,int)), this, SLOT(sourceChanged(int,int)));
+        connect(m_source, SIGNAL(pointsReset()), this, SLOT(sourceReset()));
+        connect(m_source, SIGNAL(destroyed()), this, SLOT(sourceReset()));
+    }
+    m_source_removed = 0;
+    rebuildSource();
+    updateAutoRange();
+    resetView();
+}
+
+/*!
+    \internal
+    Scrolls the widget content by the data distance \a dx and schedules
+    the repaint of the uncovered area.
+*/
+void QtBasicGraph::scrollBy(qreal dx)
+{
+    qreal deltaf = width() * (dx / m_view_range);
+    int delta = (int) deltaf;
+    m_scroll_error += (deltaf - qreal(delta));
+
+    if (m_scroll_error > qreal(1.0)) {
+        m_scroll_error--;
+        delta++;
+    }
+
+    if (delta < width() && isLayered() && !m_threaded && !m_grid_dirty) {
+        // the grid and the annotations move with the trace, only the labels
+        // of the y axis and the crosshair stay in place
+        scrollGrid(delta);
+        scrollTrace(delta);
+        scroll(-delta, 0);
+        update(width() - delta - 3, 0, delta + 3, height());
+        update(0, 0, m_grid_label_width, height());
+        if (usePersistence())
+            schedulePersistenceBand();
+        if (m_crosshair_visible) {
+            update(m_overlay_region.translated(-delta, 0));
+            updateOverlay();
+        }
+    } else if (delta < width() && isLayered()) {
+        // a render job always delivers the whole view
+        scrollGrid(delta);
+        scrollTrace(delta);
+        update();
+        if (m_crosshair_visible)
+            updateOverlay();
+    } else if (delta < width()) {
+        scroll(-delta, 0);
+        update(width() - delta - 3, 0, delta + 3, height());
+    } else {
+        m_scroll_error = 0;
+        invalidate();
+    }
+}
+
+/*!
+    \internal
+    Returns the x value at the right edge of the view.
+*/
+qreal QtBasicGraph::viewRight() const
+{
+    if (showsCapture())
+        return m_capture_right;
+    return m_follow ? lastX() : m_view_right;
+}
+
+/*!
+    \internal
+    Moves the right edge of the view to \a right. Moving it to or past the
+    newest sample switches back to following the incoming data.
+*/
+void QtBasicGraph::setViewRight(qreal right)
+{
+    if (!m_history || m_history->isEmpty() || right >= lastX()) {
+        m_follow = true;
+    } else {
+        m_follow = false;
+        m_view_right = qMax(right, m_history->firstX());
+    }
+    m_scroll_error = 0;
+    invalidate();
+}
+
+/*!
+    \internal
+    Returns true if the view has to be painted from the history because it
+    shows data that has already been purged from the live window.
+*/
+bool QtBasicGraph::usesHistory() const
+{
+    return !m_source && m_history && !m_history->isEmpty() && (!m_follow || m_view_range > m_xrange);
+}
+
 void QtBasicGraph::paintEvent(QPaintEvent *e)
 {
+    updateSprites();
+
+    if (isLayered()) {
+        updateLayers();
+
+        // the layers have the device pixel ratio of the widget, so the
+        // source rectangles are in device pixels
+        const QRect rect = e->rect();
+        const qreal dpr = m_trace_layer.devicePixelRatioF();
+        const QRectF source(QPointF(rect.topLeft()) * dpr, QSizeF(rect.size()) * dpr);
+
+        QPainter p(this);
+        p.drawPixmap(QRectF(rect), m_grid_layer, source);
+        p.setClipRect(rect);
+        if (m_grid)
+            drawGridLabels(&p);
+        drawAnnotations(&p);
+        p.drawImage(QRectF(rect), m_trace_layer, source);
+        if (m_crosshair_visible)
+            drawOverlay(&p);
+        return;
+    }
+
     QPainter p(this);
 
     if (m_render_hints)
         p.setRenderHints(m_render_hints);
 
+    if (useFastRaster()) {
+        // one buffer in the size of the widget, the exposed part is rendered
+        // into its top left corner, so scrolling with a changing strip width
+        // does not allocate
+        if (m_raster.size() != size())
+            m_raster = QImage(size(), QImage::Format_RGB32);
+
+        const QRect rect = e->rect();
+        QImage raster(m_raster.bits(), rect.width(), rect.height(), m_raster.bytesPerLine(), QImage::Format_RGB32);
+        raster.fill(palette().color(QPalette::Window));
+
+        // the annotations are below the traces, like in the other paths
+        if (m_annotations.count() > 0) {
+            QPainter painter(&raster);
+            painter.setFont(font());
+            painter.translate(-rect.topLeft());
+            drawAnnotations(&painter);
+        }
+
+        for (int i = 0; i < traceCount(); ++i) {
+            trace(i, rect, &m_trace);
+            rasterizeTrace(reinterpret_cast<quint32 *>(raster.bits()), raster.bytesPerLine() / 4,
+                           raster.width(), raster.height(), traceStyle(i), m_trace,
+                           -rect.x(), -rect.y(), &m_style_buffer);
+        }
+        p.drawImage(rect.topLeft(), raster);
+        return;
+    }
+
     p.fillRect(e->rect(), palette().background());
+    p.setClipRect(e->rect());
+    drawAnnotations(&p);
+
+    for (int i = 0; i < traceCount(); ++i) {
+        trace(i, e->rect(), &m_trace);
+        paintTrace(&p, e->rect(), traceStyle(i), m_trace, &m_style_buffer);
+    }
+}
+
+/*!
+    \overload
+    \internal
+    The layers are recreated in the new size on the next paint.
+*/
+void QtBasicGraph::resizeEvent(QResizeEvent *e)
+{
+    m_scroll_error = 0;
+    m_grid_dirty = true;
+    m_trace_dirty = rect();
+    m_render_stale = m_render_generation;
+    QWidget::resizeEvent(e);
+}
+
+/*!
+    \overload
+    \internal
+    Hides the crosshair.
+*/
+void QtBasicGraph::leaveEvent(QEvent *e)
+{
+    if (m_crosshair_visible) {
+        m_crosshair_visible = false;
+        update(m_overlay_region);
+        m_overlay_region = QRegion();
+    }
+    QWidget::leaveEvent(e);
+}
+
+/*!
+    \overload
+    \internal
+    The layers are drawn again in the new font or palette.
+*/
+void QtBasicGraph::changeEvent(QEvent *e)
+{
+    if (e->type() == QEvent::FontChange || e->type() == QEvent::PaletteChange) {
+        // the default color table of the persistence mode and the markers
+        // follow the palette
+        if (e->type() == QEvent::PaletteChange) {
+            if (!m_persistence_custom_colors)
+                m_persistence_lut.clear();
+            m_sprites.clear();
+            updateSprites();
+        }
+        m_scroll_error = 0;
+        invalidate();
+    }
+    QWidget::changeEvent(e);
+}
+
+/*!
+    \internal
+    Schedules a full repaint after the range, the view or the data changed.
+    All cached layers are rendered again.
+*/
+void QtBasicGraph::invalidate()
+{
+    m_grid_dirty = true;
+    m_trace_dirty = rect();
+    update();
+
+    // the readout follows the data under the crosshair
+    if (m_crosshair_visible)
+        updateOverlay();
+}
 
-    if (m_values.size() < 2)
+/*!
+    \internal
+    Brings the grid and the trace layer up to date before they are composed.
+*/
+void QtBasicGraph::updateLayers()
+{
+    const qreal dpr = devicePixelRatioF();
+    const QSize size = this->size() * dpr;
+
+    if (m_grid_dirty || m_grid_layer.size() != size) {
+        m_grid_layer = QPixmap(size);
+        m_grid_layer.setDevicePixelRatio(dpr);
+        m_grid_layer.fill(palette().color(QPalette::Window));
+
+        if (m_grid) {
+            QPainter p(&m_grid_layer);
+            p.setFont(font());
+            drawGrid(&p);
+        }
+        m_grid_dirty = false;
+    }
+
+    if (m_threaded) {
+        // the finished image of the job is shown until the next one is done
+        if (m_trace_layer.size() != size)
+            m_trace_dirty = rect();
+        if (!m_trace_dirty.isEmpty())
+            startRender();
+        m_trace_dirty = QRect();
         return;
+    }
 
-    p.setPen(palette().color(QPalette::Text));
+    if (m_trace_layer.size() != size || m_trace_layer.devicePixelRatioF() != dpr) {
+        m_trace_layer = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        m_trace_layer.setDevicePixelRatio(dpr);
+        m_trace_dirty = rect();
+    }
 
-    qreal scalex = qreal(width()) / m_xrange;
-    qreal scaley = qreal(height()) / (m_ymax - m_ymin);
+    const QRect dirty = m_trace_dirty & rect();
+    m_trace_dirty = QRect();
+    if (dirty.isEmpty())
+        return;
+
+    if (usePersistence()) {
+        // every frame fades the whole intensity; a new capture is added to
+        // the faded intensity, a newly traced strip replaces it
+        const bool accumulate = showsCapture() && m_capture_fresh && dirty == rect();
+        m_capture_fresh = false;
+        renderPersistence(dirty, accumulate);
+    } else {
+        renderTrace(dirty);
+    }
+}
 
-    qreal dx = qreal(3) / scalex;
-    qreal dy = qreal(3) / scaley;
+/*!
+    \internal
+    Moves the content of the grid layer \a delta pixels to the left and
+    draws the grid in the uncovered strip.
+*/
+void QtBasicGraph::scrollGrid(int delta)
+{
+    if (delta <= 0 || m_grid_dirty || m_grid_layer.isNull())
+        return;
 
-    QRectF bound(e->rect().x() / scalex, m_ymin + e->rect().y() / scaley, e->rect().width() / scalex, e->rect().height() / scaley);
+    m_grid_layer.scroll(-qRound(delta * m_grid_layer.devicePixelRatioF()), 0, m_grid_layer.rect());
 
-    QPointF last = m_values.last();
+    const QRect strip(width() - delta - 3, 0, delta + 3, height());
+    QPainter p(&m_grid_layer);
+    p.setClipRect(strip);
+    p.fillRect(strip, palette().color(QPalette::Window));
+    if (m_grid) {
+        p.setFont(font());
+        drawGrid(&p);
+    }
+}
 
-    qreal tx = m_xrange - last.x();
-    qreal ty = m_ymin;
+/*!
+    \internal
+    Moves the content of the trace layer \a delta pixels to the left and
+    marks the uncovered strip for tracing. Parts that were still waiting
+    to be traced move along.
+*/
+void QtBasicGraph::scrollTrace(int delta)
+{
+    if (delta <= 0)
+        return;
 
+    // a render job always draws the whole view
+    if (m_threaded) {
+        m_trace_dirty = rect();
+        return;
+    }
 
-    p.scale(scalex, -scaley);
-    p.translate(tx, ty);
+    if (!m_trace_layer.isNull()) {
+        const int shift = qRound(delta * m_trace_layer.devicePixelRatioF());
+        const int width = m_trace_layer.width() - shift;
 
-    QVarLengthArray<QLineF> lines;
-    
-    for (int i = m_values.size() - 1; i >= 0; --i) {
-        QPointF pt = m_values[i];
-        QRectF linerect(last, pt);
-        linerect = linerect.normalized().translated(tx, 0);
-        linerect.adjust(-dx, -dy, dx, dy);
+        for (int y = 0; width > 0 && y < m_trace_layer.height(); ++y) {
+            uchar *line = m_trace_layer.scanLine(y);
+            memmove(line, line + shift * 4, width * 4);
+        }
 
-        if (bound.intersects(linerect))
-            lines.append(QLineF(last, pt));
-        last = pt;
+        // the intensity of the persistence mode moves along
+        if (m_intensity.size() == m_trace_layer.width() * m_trace_layer.height()) {
+            for (int y = 0; width > 0 && y < m_trace_layer.height(); ++y) {
+                float *line = m_intensity.data() + y * m_trace_layer.width();
+                memmove(line, line + shift, width * sizeof(float));
+            }
+        }
     }
 
-//    if (lines.size() < (m_values.size()-1))
-//        qWarning("skipped %d lines", (m_values.size()-1) -lines.size());
+    if (!m_persistence_band.isEmpty())
+        m_persistence_band = m_persistence_band.translated(-delta, 0) & rect();
+    if (!m_trace_dirty.isEmpty())
+        m_trace_dirty.translate(-delta, 0);
+    m_trace_dirty = (m_trace_dirty | QRect(width() - delta - 3, 0, delta + 3, height())) & rect();
+}
 
-    p.drawLines(lines.constData(), lines.size());
+/*!
+    \internal
+    Returns a step of 1, 2 or 5 times a power of ten that divides \a range
+    into about \a ticks parts.
+*/
+static qreal gridStep(qreal range, int ticks)
+{
+    const qreal raw = range / qMax(ticks, 1);
+    const qreal magnitude = qPow(10, qFloor(std::log10(raw)));
+    const qreal norm = raw / magnitude;
+
+    if (norm < 1.5)
+        return magnitude;
+    if (norm < 3)
+        return 2 * magnitude;
+    if (norm < 7)
+        return 5 * magnitude;
+    return 10 * magnitude;
 }
 
+/*!
+    \internal
+    Returns the advance of \a text in the font of \a metrics.
+*/
+static int textWidth(const QFontMetrics &metrics, const QString &text)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    return metrics.horizontalAdvance(text);
+#else
+    return metrics.width(text);
+#endif
+}
 
+/*!
+    \internal
+    Draws the grid lines and the labels of the x values. The vertical lines
+    are fixed to the data, so the layer can be scrolled with the trace. The
+    line right of the view is drawn as well, its label already reaches into
+    the view.
+*/
+void QtBasicGraph::drawGrid(QPainter *painter)
+{
+    const qreal range = m_ymax - m_ymin;
+    if (range <= 0 || m_view_range <= 0 || width() <= 0 || height() <= 0)
+        return;
+
+    const QColor line = palette().color(QPalette::Mid);
+    const QColor text = palette().color(QPalette::Text);
+
+    const qreal ystep = gridStep(range, qMax(2, height() / 40));
+    painter->setPen(line);
+    for (qreal v = qCeil(m_ymin / ystep) * ystep; v <= m_ymax; v += ystep) {
+        const int y = qRound((m_ymax - v) * height() / range);
+        painter->drawLine(0, y, width(), y);
+    }
+
+    const qreal left = viewRight() - m_view_range;
+    const qreal scale = width() / m_view_range;
+    const qreal xstep = gridStep(m_view_range, qMax(2, width() / 80));
+    const qint64 last = qint64(std::floor((left + m_view_range) / xstep)) + 1;
+    for (qint64 i = qint64(std::ceil(left / xstep)); i <= last; ++i) {
+        const qreal v = i * xstep;
+        const int x = qRound((v - left) * scale) - 1;
+        painter->setPen(line);
+        painter->drawLine(x, 0, x, height());
+        painter->setPen(text);
+        const QString label = QString::number(i == 0 ? 0 : v);
+        painter->drawText(x - 2 - textWidth(painter->fontMetrics(), label), height() - 2, label);
+    }
+}
+
+/*!
+    \internal
+    Draws the labels of the y values at the left edge. They stay in place
+    while the grid scrolls, so they are drawn while composing.
+*/
+void QtBasicGraph::drawGridLabels(QPainter *painter)
+{
+    const qreal range = m_ymax - m_ymin;
+    if (range <= 0 || height() <= 0)
+        return;
+
+    const QFontMetrics metrics = painter->fontMetrics();
+    const int ascent = metrics.ascent();
+    int labelWidth = 0;
+
+    painter->setPen(palette().color(QPalette::Text));
+    const qreal ystep = gridStep(range, qMax(2, height() / 40));
+    for (qreal v = qCeil(m_ymin / ystep) * ystep; v <= m_ymax; v += ystep) {
+        const int y = qRound((m_ymax - v) * height() / range);
+        const QString label = QString::number(qAbs(v) < ystep / 2 ? 0 : v);
+        painter->drawText(2, qMax(ascent, y - 2), label);
+        labelWidth = qMax(labelWidth, textWidth(metrics, label));
+    }
+
+    // repainted after every scroll
+    m_grid_label_width = labelWidth + 4;
+}
+
+/*!
+    \internal
+    Draws the markers and spans in the view, spans shaded and markers as a
+    vertical line, both with their label at the top. Every paint path draws
+    them above the background and grid and below the traces.
+*/
+void QtBasicGraph::drawAnnotations(QPainter *painter)
+{
+    if (m_annotations.count() == 0 || m_view_range <= 0)
+        return;
+
+    const qreal right = viewRight();
+    const qreal left = right - m_view_range;
+    m_annotations.find(left, right, &m_visible_annotations);
+    if (m_visible_annotations.isEmpty())
+        return;
+
+    const qreal scale = width() / m_view_range;
+    const int ascent = painter->fontMetrics().ascent();
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+
+    foreach (const QtBasicGraphAnnotations::Annotation &annotation, m_visible_annotations) {
+        const QColor color = annotation.color.isValid() ? annotation.color : palette().color(QPalette::Highlight);
+        const int x0 = qRound((annotation.start - left) * scale);
+        const int x1 = qRound((annotation.end - left) * scale);
+
+        if (x1 > x0) {
+            QColor fill = color;
+            fill.setAlphaF(color.alphaF() * 0.2);
+            painter->fillRect(QRect(x0, 0, x1 - x0, height()), fill);
+        } else {
+            painter->setPen(color);
+            painter->drawLine(x0, 0, x0, height());
+        }
+
+        if (!annotation.text.isEmpty()) {
+            painter->setPen(color);
+            painter->drawText(x0 + 3, ascent + 2, annotation.text);
+        }
+    }
+
+    painter->restore();
+}
+
+/*!
+    \overload
+    \internal
+    Zooms the view. While following the incoming data the right edge stays
+    at the newest sample, otherwise the x value under the mouse stays fixed.
+*/
+void QtBasicGraph::wheelEvent(QWheelEvent *e)
+{
+    if (!m_history || m_history->isEmpty()) {
+        QWidget::wheelEvent(e);
+        return;
+    }
+
+    const qreal factor = qPow(qreal(1.25), -e->angleDelta().y() / qreal(120));
+    const qreal span = qMax(m_history->lastX() - m_history->firstX(), m_xrange);
+    const qreal range = qBound(m_xrange / 1000, m_view_range * factor, span);
+
+    if (m_follow) {
+        setViewRange(range);
+    } else {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        const qreal pos = 1 - e->position().x() / width();
+#else
+        const qreal pos = 1 - qreal(e->pos().x()) / width();
+#endif
+        const qreal anchor = viewRight() - pos * m_view_range;
+        m_view_range = range;
+        setViewRight(anchor + pos * range);
+    }
+
+    e->accept();
+}
+
+/*!
+    \overload
+    \internal
+    Starts panning the view.
+*/
+void QtBasicGraph::mousePressEvent(QMouseEvent *e)
+{
+    if (e->button() == Qt::LeftButton && m_history) {
+        m_drag_start_pos = e->pos();
+        m_drag_start_right = viewRight();
+    }
+    QWidget::mousePressEvent(e);
+}
+
+/*!
+    \overload
+    \internal
+    Pans the view while the left mouse button is pressed.
+*/
+void QtBasicGraph::mouseMoveEvent(QMouseEvent *e)
+{
+    if ((e->buttons() & Qt::LeftButton) && m_history) {
+        const int dx = e->pos().x() - m_drag_start_pos.x();
+        setViewRight(m_drag_start_right - dx * m_view_range / width());
+    }
+
+    if (m_crosshair) {
+        m_crosshair_pos = e->pos();
+        m_crosshair_visible = true;
+        updateOverlay();
+    }
+    QWidget::mouseMoveEvent(e);
+}
+
+/*!
+    \overload
+    \internal
+    Returns to the live view.
+*/
+void QtBasicGraph::mouseDoubleClickEvent(QMouseEvent *e)
+{
+    if (m_history)
+        resetView();
+    QWidget::mouseDoubleClickEvent(e);
+}
@@ -13,11 +13,33 @@
 #include <QtGui>
 #include <QWidget>
 
+#include <QtCore/QBasicTimer>
+
+#include <deque>
+
+#include "qtbasicgraphannotations.h"
+#include "qtbasicgraphmodelsource.h"
+
+class QtBasicGraphHistory;
+class QThreadPool;
 
 class QtBasicGraph : public QWidget {
     Q_OBJECT
 
 public:
+    enum TriggerMode {
+        NoTrigger,
+        RisingEdge,
+        FallingEdge
+    };
+
+    enum RenderStyle {
+        Lines,
+        Steps,
+        Scatter,
+        FilledArea
+    };
+
     explicit QtBasicGraph(QWidget * parent);
     ~QtBasicGraph();
 
@@ -31,16 +53,207 @@ public:
 
     void setRenderHints(QPainter::RenderHints hints);
 
+    void setRenderStyle(RenderStyle style);
+    RenderStyle renderStyle() const { return m_render_style; }
+
+    void setFastRasterization(bool enabled);
+    bool hasFastRasterization() const { return m_fast_raster; }
+
+    void setSampleInterval(qreal interval);
+    qreal sampleInterval() const { return m_sample_interval; }
+    bool isFixedRate() const     { return m_sample_interval > 0; }
+
+    int sampleCount() const;
+
+    void setHistory(QtBasicGraphHistory *history);
+    QtBasicGraphHistory *history() const { return m_history; }
+
+    void setViewRange(qreal range);
+    qreal viewRange() const   { return m_view_range; }
+    bool isFollowing() const  { return m_follow; }
+
+    void setAutoRange(bool enabled);
+    bool hasAutoRange() const { return m_auto_range; }
+    void setAutoRangeHysteresis(qreal hysteresis);
+    qreal autoRangeHysteresis() const { return m_auto_range_hysteresis; }
+
+    void setStatisticsEnabled(bool enabled);
+    bool hasStatistics() const { return m_statistics; }
+    qreal mean() const;
+    qreal standardDeviation() const;
+    qreal minimum() const;
+    qreal maximum() const;
+
+    void setGridVisible(bool visible);
+    bool isGridVisible() const { return m_grid; }
+    void setCrosshairEnabled(bool enabled);
+    bool hasCrosshair() const  { return m_crosshair; }
+
+    void setModel(QAbstractItemModel *model, int xColumn, const QList<int> &yColumns);
+    void setModelSource(QtBasicGraphModelSource *source);
+    QtBasicGraphModelSource *modelSource() const { return m_source; }
+
+    void setTrigger(TriggerMode mode, qreal level);
+    TriggerMode triggerMode() const { return m_trigger_mode; }
+    qreal triggerLevel() const      { return m_trigger_level; }
+    void setTriggerPosition(qreal position);
+    qreal triggerPosition() const   { return m_trigger_position; }
+    void setTriggerSingleShot(bool singleShot);
+    bool isTriggerSingleShot() const { return m_trigger_single; }
+    bool isTriggerArmed() const     { return m_trigger_armed || m_trigger_pending; }
+
+    void setThreadedRendering(bool enabled);
+    bool hasThreadedRendering() const { return m_threaded; }
+
+    void setPersistence(bool enabled);
+    bool hasPersistence() const { return m_persistence; }
+    void setPersistenceDecay(qreal decay);
+    qreal persistenceDecay() const { return m_persistence_decay; }
+    void setPersistenceSaturation(qreal hits);
+    qreal persistenceSaturation() const { return m_persistence_saturation; }
+    void setPersistenceColors(const QVector<QRgb> &colors);
+
+    void addMarker(qreal x, const QString &text = QString(), const QColor &color = QColor());
+    void addSpan(qreal start, qreal end, const QString &text = QString(), const QColor &color = QColor());
+    void clearAnnotations();
+    int annotationCount() const { return m_annotations.count(); }
+
+    bool nearestSample(const QPoint &pos, QPointF *sample, int *trace = 0) const;
+    QPointF mapFromData(const QPointF &sample) const;
+    QPointF mapToData(const QPoint &pos) const;
+
+Q_SIGNALS:
+    void yRangeChanged(qreal ymin, qreal ymax);
+    void triggered(qreal x);
+    void statisticsChanged(qreal mean, qreal deviation, qreal minimum, qreal maximum);
+
 public Q_SLOTS:
     virtual void addPoint(const QPointF &data);
+    virtual void addSample(qreal y);
+    virtual void addSamples(const float *y, int count);
     virtual void clear();
+    void resetView();
+    void armTrigger();
+
+private Q_SLOTS:
+    void sourceInserted(int first, int count);
+    void sourceAboutToBeRemoved(int first, int count);
+    void sourceRemoved(int first, int count);
+    void sourceChanged(int first, int count);
+    void sourceReset();
+    void renderFinished(const QImage &image, qint64 generation);
 
 protected:
     virtual void paintEvent(QPaintEvent *e);
+    virtual void resizeEvent(QResizeEvent *e);
+    virtual void leaveEvent(QEvent *e);
+    virtual void changeEvent(QEvent *e);
+    virtual void timerEvent(QTimerEvent *e);
+    virtual void wheelEvent(QWheelEvent *e);
+    virtual void mousePressEvent(QMouseEvent *e);
+    virtual void mouseMoveEvent(QMouseEvent *e);
+    virtual void mouseDoubleClickEvent(QMouseEvent *e);
 
 private:
+    // samples of a live trace, either points, samples with the x values x
+    // or fixed-rate samples with the x value x0 + index * interval
+    struct TraceData {
+        const QPointF *points;
+        const qreal *x;
+        const float *samples;
+        int count;
+        qreal x0;
+        qreal interval;
+    };
+
+    // mapping of the view to a width x height device rectangle
+    struct TraceView {
+        int width;
+        int height;
+        qreal left;
+        qreal range;
+        qreal ymin;
+        qreal ymax;
+    };
+
+    // how a traced polyline is drawn, base is the y coordinate of the zero
+    // line a filled area is filled to
+    struct TraceStyle {
+        RenderStyle style;
+        QColor color;
+        QImage sprite;
+        qreal base;
+    };
+
+    enum {
+        MarkerSize = 5,         // diameter of the scatter markers
+        PersistenceBands = 8    // frames the density image needs to follow the decay
+    };
+
+    class RenderJob;
+
     void drawValues(QPainter * painter);
-    
+    int traceCount() const;
+    QColor traceColor(int index) const;
+    TraceStyle traceStyle(int index) const;
+    void updateSprites();
+    static void paintTrace(QPainter *painter, const QRect &rect, const TraceStyle &style,
+                           const QVector<QPointF> &points, QVector<QPointF> *buffer);
+    static void rasterizeTrace(quint32 *bits, int stride, int width, int height, const TraceStyle &style,
+                               const QVector<QPointF> &points, qreal dx, qreal dy, QVector<QPointF> *buffer);
+    void trace(int index, const QRect &rect, QVector<QPointF> *points) const;
+    void traceLive(const QRect &rect, const QPointF *data, int count, QVector<QPointF> *points) const;
+    TraceView traceView() const;
+    static void traceSamples(const TraceView &view, const QRect &rect, const TraceData &data,
+                             QVector<QPointF> *points);
+    void traceHistory(const QRect &rect, QVector<QPointF> *points) const;
+    bool useFastRaster() const;
+    bool isLayered() const { return m_grid || m_crosshair || m_persistence || m_threaded; }
+    bool usePersistence() const;
+    void invalidate();
+    void updateLayers();
+    void renderTrace(const QRect &rect);
+    void renderPersistence(const QRect &rect, bool accumulate);
+    void schedulePersistenceBand();
+    void startRender();
+    void scrollGrid(int delta);
+    void scrollTrace(int delta);
+    void drawGrid(QPainter *painter);
+    void drawGridLabels(QPainter *painter);
+    void drawAnnotations(QPainter *painter);
+    void drawOverlay(QPainter *painter);
+    void updateOverlay();
+    void advance(qreal dx);
+    void scrollBy(qreal dx);
+    void updateSourceRange(int first, int last);
+    void trackSourceRow(int row);
+    void purgeSource(qreal left);
+    void rebuildSource();
+    void updateX(qreal x0, qreal x1);
+    void purge(qreal left);
+    void updateTrigger();
+    void copyCapture();
+    bool showsCapture() const { return m_trigger_mode != NoTrigger && m_capture_valid; }
+    void trackRange(qint64 serial, float y);
+    void trackExtremes(qint64 serial, float y);
+    void untrackRange(int count);
+    void rebuildRange();
+    void dropRange();
+    bool updateAutoRange();
+    void scheduleStatistics();
+
+    const QPointF *values() const { return m_values.constData() + m_value_offset; }
+    const float *samples() const  { return m_samples.constData() + m_sample_offset; }
+    int lowerBound(qreal x) const;
+    int liveCount() const;
+    qint64 firstSerial() const;
+    qreal sampleX(int index) const;
+    QPointF liveSample(int index) const;
+    qreal lastX() const;
+    qreal viewRight() const;
+    void setViewRight(qreal right);
+    bool usesHistory() const;
+
     qreal m_ymin;
     qreal m_ymax;
     qreal m_xrange;
@@ -48,7 +261,136 @@ private:
 
     QPainter::RenderHints m_render_hints;
 
-    QList<QPointF> m_values;
+    bool m_fast_raster;
+    QImage m_raster;
+
+    // the scatter markers are blitted from one cached sprite per color
+    RenderStyle m_render_style;
+    QHash<QRgb, QImage> m_sprites;
+    qreal m_sprite_dpr;
+    QVector<QPointF> m_style_buffer;
+
+    QVector<QPointF> m_values;
+    int m_value_offset;
+    qint64 m_purged_values;
+
+    // fixed-rate mode: only the y values are stored, the x value of a
+    // sample is m_origin_x + (m_first_sample + index) * m_sample_interval
+    QVector<float> m_samples;
+    int m_sample_offset;
+    qint64 m_first_sample;
+    qreal m_origin_x;
+    qreal m_sample_interval;
+
+    // zoom and pan over the history, while m_follow is set the right
+    // edge of the view is the newest sample
+    QtBasicGraphHistory *m_history;
+    QVector<QPointF> m_trace;
+    qreal m_view_range;
+    qreal m_view_right;
+    bool m_follow;
+    QPoint m_drag_start_pos;
+    qreal m_drag_start_right;
+
+    // model-bound mode: the traces are read from the source instead of the
+    // data added with addPoint(); the rows from m_source_first on are the
+    // live window that feeds the auto range, the statistics and the trigger;
+    // the running number of a row counts the rows removed from the front
+    QPointer<QtBasicGraphModelSource> m_source;
+    int m_source_first;
+    qint64 m_source_removed;
+
+    // triggered mode: the incoming samples are scanned for a crossing of
+    // the trigger level from m_trigger_serial on; a capture is shown with
+    // its right edge at m_capture_right and read from the live samples
+    // until they are purged, only then it is copied into m_capture
+    TriggerMode m_trigger_mode;
+    qreal m_trigger_level;
+    qreal m_trigger_position;
+    bool m_trigger_single;
+    bool m_trigger_armed;
+    bool m_trigger_pending;
+    qreal m_trigger_x;
+    qint64 m_trigger_serial;
+    bool m_capture_valid;
+    qreal m_capture_right;
+    QVector<QPointF> m_capture;
+    bool m_capture_fresh;
+
+    // persistence: hits per pixel of the trace layer, the intensity decays
+    // with every rendered frame and is mapped through m_persistence_lut; the
+    // intensity of a pixel is m_intensity * m_persistence_scale, so the decay
+    // is one multiply per frame, and the columns of m_persistence_band are
+    // mapped again with the next frame
+    bool m_persistence;
+    qreal m_persistence_decay;
+    qreal m_persistence_saturation;
+    bool m_persistence_custom_colors;
+    QVector<quint32> m_persistence_lut;
+    QVector<float> m_intensity;
+    QVector<float> m_hits;
+    qreal m_persistence_scale;
+    QRect m_persistence_band;
+    int m_persistence_next_band;
+
+    // threaded rendering: one job at a time traces and renders the trace
+    // layer from a snapshot of the shared sample arrays, a request while it
+    // runs is remembered and started with a new snapshot when the job is
+    // finished; m_render_generation numbers the jobs, the images of jobs up
+    // to m_render_stale were started for an outdated size or mode
+    bool m_threaded;
+    bool m_render_running;
+    bool m_render_pending;
+    qint64 m_render_generation;
+    qint64 m_render_stale;
+    QThreadPool *m_render_pool;
+
+    // auto range: monotonic queues of the samples that can still become
+    // the minimum and maximum of the live window, oldest first
+    struct RangeEntry {
+        qint64 serial;
+        float value;
+    };
+
+    bool m_auto_range;
+    qreal m_auto_range_hysteresis;
+    std::deque<RangeEntry> m_range_min;
+    std::deque<RangeEntry> m_range_max;
+
+    // statistics: running mean and sum of squared deviations of the live
+    // window (Welford), samples leaving the window are removed again; the
+    // minimum and maximum come from the auto range queues
+    bool m_statistics;
+    qint64 m_stats_count;
+    double m_stats_mean;
+    double m_stats_m2;
+    QBasicTimer m_stats_timer;
+
+    // event markers and spans, purged with the live window unless a
+    // history keeps the older data
+    QtBasicGraphAnnotations m_annotations;
+    QVector<QtBasicGraphAnnotations::Annotation> m_visible_annotations;
+
+    // layered compositing: the grid and the trace have a layer each, both
+    // are scrolled in place with the data; the labels of the y axis and the
+    // crosshair overlay are drawn on top while composing
+    bool m_grid;
+    bool m_grid_dirty;
+    QPixmap m_grid_layer;
+    int m_grid_label_width;
+    QImage m_trace_layer;
+    QRect m_trace_dirty;
+    bool m_crosshair;
+    bool m_crosshair_visible;
+    QPoint m_crosshair_pos;
+
+    // the crosshair overlay at m_crosshair_pos, computed with one search
+    // for the nearest sample whenever the mouse or the data moves, so
+    // painting only draws it
+    QString m_readout;
+    QRect m_readout_rect;
+    QRect m_marker_rect;
+    QRegion m_overlay_region;
 };
 
 #endif // QT_BASIC_GRAPH_H
@@ -0,0 +1,214 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraphannotations.h"
+
+#include <algorithm>
+
+static bool lessStart(const QtBasicGraphAnnotations::Annotation &a, const QtBasicGraphAnnotations::Annotation &b)
+{
+    return a.start < b.start;
+}
+
+/*!
+
+    \class QtBasicGraphAnnotations qtbasicgraphannotations.h
+
+    \brief The QtBasicGraphAnnotations class stores the event markers and
+    spans of a QtBasicGraph.
+
+    The annotations are kept in an interval index, so find() only visits
+    the annotations overlapping the requested range plus O(log n) others,
+    no matter how many events were added. The index is a sorted array that
+    is read as an implicit binary search tree, augmented with the largest
+    end of every subtree.
+
+    Annotations usually arrive in time order, so add() only appends them.
+    They are merged into the index in batches once enough have collected,
+    until then find() scans them linearly. purge() drops the annotations
+    that ended before the live window of the graph. It merges the batches
+    as well, so annotations are purged even if the graph is never painted.
+
+*/
+
+QtBasicGraphAnnotations::QtBasicGraphAnnotations()
+    : m_indexed(0), m_levels(0)
+{
+}
+
+/*!
+    Adds \a annotation. The end must not be less than the start.
+*/
+void QtBasicGraphAnnotations::add(const Annotation &annotation)
+{
+    m_items.append(annotation);
+}
+
+/*!
+    Removes the annotations that ended before \a left. The array is only
+    compacted once at least half of the indexed annotations start before
+    \a left, so purging stays amortized O(1) per annotation.
+*/
+void QtBasicGraphAnnotations::purge(qreal left)
+{
+    // the appended annotations are only searched once they are indexed
+    indexTail();
+
+    Annotation key;
+    key.start = left;
+    const int started = std::lower_bound(m_items.constBegin(), m_items.constBegin() + m_indexed, key, lessStart)
+                        - m_items.constBegin();
+    if (started <= MinTail || started < m_indexed / 2)
+        return;
+
+    auto ended = [left](const Annotation &a) { return a.end < left; };
+    const int removed = std::count_if(m_items.constBegin(), m_items.constBegin() + m_indexed, ended);
+    const QVector<Annotation>::iterator end = std::remove_if(m_items.begin(), m_items.end(), ended);
+    m_items.erase(end, m_items.end());
+
+    // remove_if keeps the order, so the indexed annotations are still
+    // sorted and only the largest ends of the subtrees change
+    m_indexed -= removed;
+    updateMaxEnd();
+}
+
+/*!
+    Removes all annotations.
+*/
+void QtBasicGraphAnnotations::clear()
+{
+    m_items.clear();
+    m_max_end.clear();
+    m_indexed = 0;
+    m_levels = 0;
+}
+
+/*!
+    Sets \a result to the annotations overlapping the range from \a x0 to
+    \a x1, including the ones that touch it.
+*/
+void QtBasicGraphAnnotations::find(qreal x0, qreal x1, QVector<Annotation> *result)
+{
+    result->clear();
+
+    indexTail();
+
+    const Annotation *items = m_items.constData();
+    const int n = m_indexed;
+
+    // iterative in-order walk of the implicit tree, skipping every subtree
+    // whose largest end is left of x0 and every right subtree starting
+    // behind x1
+    struct Node {
+        int x;
+        int k;
+        bool visited;
+    };
+    Node stack[64];
+    int top = 0;
+
+    if (n > 0) {
+        const Node root = { (1 << m_levels) - 1, m_levels, false };
+        stack[top++] = root;
+    }
+
+    while (top > 0) {
+        const Node z = stack[--top];
+
+        if (z.k <= LeafLevel) {
+            const int i0 = z.x >> z.k << z.k;
+            const int i1 = qMin(i0 + (1 << (z.k + 1)) - 1, n);
+            for (int i = i0; i < i1 && items[i].start <= x1; ++i) {
+                if (items[i].end >= x0)
+                    result->append(items[i]);
+            }
+        } else if (!z.visited) {
+            const int y = z.x - (1 << (z.k - 1));
+            const Node self = { z.x, z.k, true };
+            stack[top++] = self;
+            if (y >= n || m_max_end.at(y) >= x0) {
+                const Node left = { y, z.k - 1, false };
+                stack[top++] = left;
+            }
+        } else if (z.x < n && items[z.x].start <= x1) {
+            if (items[z.x].end >= x0)
+                result->append(items[z.x]);
+            const Node right = { z.x + (1 << (z.k - 1)), z.k - 1, false };
+            stack[top++] = right;
+        }
+    }
+
+    for (int i = n; i < m_items.size(); ++i) {
+        if (items[i].start <= x1 && items[i].end >= x0)
+            result->append(items[i]);
+    }
+}
+
+/*!
+    \internal
+    Merges the appended annotations into the sorted array and rebuilds the
+    largest ends of all subtrees.
+*/
+void QtBasicGraphAnnotations::index()
+{
+    std::stable_sort(m_items.begin() + m_indexed, m_items.end(), lessStart);
+    std::inplace_merge(m_items.begin(), m_items.begin() + m_indexed, m_items.end(), lessStart);
+
+    m_indexed = m_items.size();
+    updateMaxEnd();
+}
+
+/*!
+    \internal
+    Indexes the appended annotations once there are more than MinTail of
+    them and they make up more than 1/16 of the indexed ones, which keeps
+    both the linear scan and the cost of merging small.
+*/
+void QtBasicGraphAnnotations::indexTail()
+{
+    if (m_items.size() - m_indexed > MinTail + m_indexed / 16)
+        index();
+}
+
+/*!
+    \internal
+    Computes the largest end of every subtree of the indexed annotations.
+*/
+void QtBasicGraphAnnotations::updateMaxEnd()
+{
+    const int n = m_indexed;
+    m_levels = 0;
+    m_max_end.resize(n);
+    if (n == 0)
+        return;
+
+    // leaves first, then every level from the ones below; last is the
+    // largest end of the rightmost subtree, which stands in for children
+    // that are missing because n is not a power of two
+    int last_i = 0;
+    qreal last = 0;
+    for (int i = 0; i < n; i += 2) {
+        last_i = i;
+        m_max_end[i] = last = m_items.at(i).end;
+    }
+
+    int k = 1;
+    for (; (1 << k) <= n; ++k) {
+        const int x = 1 << (k - 1);
+        for (int i = (x << 1) - 1; i < n; i += x << 2) {
+            const qreal left = m_max_end.at(i - x);
+            const qreal right = i + x < n ? m_max_end.at(i + x) : last;
+            m_max_end[i] = qMax(m_items.at(i).end, qMax(left, right));
+        }
+
+        last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+        if (last_i < n && m_max_end.at(last_i) > last)
+            last = m_max_end.at(last_i);
+    }
+    m_levels = k - 1;
+}
@@ -0,0 +1,58 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Event markers and spans of QtBasicGraph in an interval index.
+#ifndef QT_BASIC_GRAPH_ANNOTATIONS_H
+#define QT_BASIC_GRAPH_ANNOTATIONS_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QColor>
+
+
+class QtBasicGraphAnnotations
+{
+public:
+    // a span from start to end, a marker has start == end
+    struct Annotation {
+        qreal start;
+        qreal end;
+        QString text;
+        QColor color;
+    };
+
+    QtBasicGraphAnnotations();
+
+    void add(const Annotation &annotation);
+    void purge(qreal left);
+    void clear();
+
+    int count() const { return m_items.size(); }
+    void find(qreal x0, qreal x1, QVector<Annotation> *result);
+
+private:
+    void index();
+    void indexTail();
+    void updateMaxEnd();
+
+    enum {
+        LeafLevel = 3,     // subtrees up to this level are scanned linearly
+        MinTail = 32       // annotations that are scanned before indexing
+    };
+
+    // m_items[0, m_indexed) is sorted by start and forms an implicit
+    // binary tree: the node at index i is on level k if i has k trailing
+    // one bits, m_max_end[i] is the largest end in its subtree. Newer
+    // annotations are appended behind it and indexed in batches.
+    QVector<Annotation> m_items;
+    QVector<qreal> m_max_end;
+    int m_indexed;
+    int m_levels;
+};
+
+#endif // QT_BASIC_GRAPH_ANNOTATIONS_H
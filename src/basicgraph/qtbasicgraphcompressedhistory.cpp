@@ -0,0 +1,296 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraphcompressedhistory.h"
+
+#include <QtCore/QtAlgorithms>
+
+#include <string.h>
+
+/*!
+
+    \class QtBasicGraphCompressedHistory qtbasicgraphcompressedhistory.h
+
+    \brief The QtBasicGraphCompressedHistory class keeps the history of a
+    QtBasicGraph compressed in memory.
+
+    The newest \a chunkSize samples are kept uncompressed. Older samples are
+    stored in compressed chunks as described for the Gorilla time series
+    database: the x values are quantized to multiples of \a xResolution and
+    stored as delta of deltas, which takes a single bit for samples of a
+    constant rate. The y values are stored with float precision as the XOR
+    with the previous value, so slowly changing signals need only a few bits
+    per sample.
+
+    A chunk is only decompressed when a paint reads samples from it. The two
+    most recently used chunks are kept decoded.
+
+    \code
+        QtBasicGraph * graph = new QtBasicGraph(this);
+        graph->setHistory(new QtBasicGraphCompressedHistory(0.001));
+    \endcode
+
+    \sa QtBasicGraph::setHistory()
+
+*/
+
+namespace {
+
+inline quint64 lowBits(int bits)
+{
+    return bits >= 64 ? ~quint64(0) : (quint64(1) << bits) - 1;
+}
+
+inline qint64 signExtend(quint64 value, int bits)
+{
+    return qint64(value << (64 - bits)) >> (64 - bits);
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter(QVector<quint64> *words) : m_words(words), m_used(64) {}
+
+    void write(quint64 value, int bits)
+    {
+        while (bits > 0) {
+            if (m_used == 64) {
+                m_words->append(0);
+                m_used = 0;
+            }
+            const int n = qMin(bits, 64 - m_used);
+            const quint64 part = (value >> (bits - n)) & lowBits(n);
+            m_words->last() |= part << (64 - m_used - n);
+            m_used += n;
+            bits -= n;
+        }
+    }
+
+private:
+    QVector<quint64> *m_words;
+    int m_used;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const quint64 *words) : m_words(words), m_used(0) {}
+
+    quint64 read(int bits)
+    {
+        quint64 value = 0;
+        while (bits > 0) {
+            const int n = qMin(bits, 64 - m_used);
+            const quint64 part = (*m_words >> (64 - m_used - n)) & lowBits(n);
+            value = (n == 64) ? part : (value << n) | part;
+            m_used += n;
+            bits -= n;
+            if (m_used == 64) {
+                ++m_words;
+                m_used = 0;
+            }
+        }
+        return value;
+    }
+
+    bool bit()
+    {
+        const bool set = (*m_words >> (63 - m_used)) & 1;
+        if (++m_used == 64) {
+            ++m_words;
+            m_used = 0;
+        }
+        return set;
+    }
+
+private:
+    const quint64 *m_words;
+    int m_used;
+};
+
+inline quint32 floatBits(float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(quint32 bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+/*!
+    Creates a history that quantizes x values to multiples of \a xResolution
+    and compresses chunks of \a chunkSize samples.
+*/
+QtBasicGraphCompressedHistory::QtBasicGraphCompressedHistory(qreal xResolution, int chunkSize)
+    : QtBasicGraphChunkedHistory(chunkSize), m_x_resolution(xResolution > 0 ? xResolution : 1e-6),
+    m_compressed_size(0), m_cache_next(0)
+{
+    m_cache_index[0] = m_cache_index[1] = -1;
+}
+
+/*!
+    Destructor
+*/
+QtBasicGraphCompressedHistory::~QtBasicGraphCompressedHistory()
+{
+}
+
+/*!
+    \internal
+    Compresses \a points into a new chunk.
+*/
+void QtBasicGraphCompressedHistory::storeChunk(const QVector<QPointF> &points)
+{
+    QVector<quint64> words;
+    BitWriter writer(&words);
+
+    qint64 ticks = qRound64(points.first().x() / m_x_resolution);
+    qint64 delta = 0;
+    quint32 value = floatBits(float(points.first().y()));
+    int leading = -1;
+    int trailing = 0;
+
+    writer.write(quint64(ticks), 64);
+    writer.write(value, 32);
+
+    for (int i = 1; i < points.size(); ++i) {
+        const QPointF &pt = points.at(i);
+
+        // x: delta of deltas in variable length buckets
+        const qint64 t = qRound64(pt.x() / m_x_resolution);
+        const qint64 dod = (t - ticks) - delta;
+        delta = t - ticks;
+        ticks = t;
+
+        if (dod == 0) {
+            writer.write(0, 1);
+        } else if (dod >= -64 && dod < 64) {
+            writer.write(0x2, 2);
+            writer.write(quint64(dod), 7);
+        } else if (dod >= -256 && dod < 256) {
+            writer.write(0x6, 3);
+            writer.write(quint64(dod), 9);
+        } else if (dod >= -2048 && dod < 2048) {
+            writer.write(0xe, 4);
+            writer.write(quint64(dod), 12);
+        } else {
+            writer.write(0xf, 4);
+            writer.write(quint64(dod), 64);
+        }
+
+        // y: XOR with the previous value, reusing the previous window of
+        // meaningful bits if the new one fits into it
+        const quint32 v = floatBits(float(pt.y()));
+        const quint32 x = v ^ value;
+        value = v;
+
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+
+        const int lz = qMin(int(qCountLeadingZeroBits(x)), 31);
+        const int tz = int(qCountTrailingZeroBits(x));
+
+        if (leading >= 0 && lz >= leading && tz >= trailing) {
+            writer.write(0x2, 2);
+            writer.write(x >> trailing, 32 - leading - trailing);
+        } else {
+            const int length = 32 - lz - tz;
+            writer.write(0x3, 2);
+            writer.write(quint64(lz), 5);
+            writer.write(quint64(length - 1), 5);
+            writer.write(x >> tz, length);
+            leading = lz;
+            trailing = tz;
+        }
+    }
+
+    words.squeeze();
+    m_compressed_size += words.size() * sizeof(quint64);
+    m_chunks.append(words);
+}
+
+/*!
+    \internal
+    Returns the decompressed samples of the chunk \a index.
+*/
+const QPointF *QtBasicGraphCompressedHistory::chunk(int index) const
+{
+    for (int i = 0; i < 2; ++i) {
+        if (m_cache_index[i] == index)
+            return m_cache[i].constData();
+    }
+
+    const int slot = m_cache_next;
+    m_cache_next = 1 - m_cache_next;
+
+    m_cache[slot].resize(chunkSize());
+    decode(index, m_cache[slot].data());
+    m_cache_index[slot] = index;
+    return m_cache[slot].constData();
+}
+
+void QtBasicGraphCompressedHistory::clearChunks()
+{
+    m_chunks.clear();
+    m_compressed_size = 0;
+    m_cache_index[0] = m_cache_index[1] = -1;
+}
+
+/*!
+    \internal
+    Decompresses the chunk \a index into \a points.
+*/
+void QtBasicGraphCompressedHistory::decode(int index, QPointF *points) const
+{
+    BitReader reader(m_chunks.at(index).constData());
+
+    qint64 ticks = qint64(reader.read(64));
+    qint64 delta = 0;
+    quint32 value = quint32(reader.read(32));
+    int leading = 0;
+    int trailing = 0;
+
+    points[0] = QPointF(ticks * m_x_resolution, bitsFloat(value));
+
+    const int count = chunkSize();
+    for (int i = 1; i < count; ++i) {
+        qint64 dod = 0;
+        if (reader.bit()) {
+            if (!reader.bit())
+                dod = signExtend(reader.read(7), 7);
+            else if (!reader.bit())
+                dod = signExtend(reader.read(9), 9);
+            else if (!reader.bit())
+                dod = signExtend(reader.read(12), 12);
+            else
+                dod = qint64(reader.read(64));
+        }
+        delta += dod;
+        ticks += delta;
+
+        if (reader.bit()) {
+            if (reader.bit()) {
+                leading = int(reader.read(5));
+                const int length = int(reader.read(5)) + 1;
+                trailing = 32 - leading - length;
+            }
+            value ^= quint32(reader.read(32 - leading - trailing)) << trailing;
+        }
+
+        points[i] = QPointF(ticks * m_x_resolution, bitsFloat(value));
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Compressed in-memory history of QtBasicGraph.
+#ifndef QT_BASIC_GRAPH_COMPRESSED_HISTORY_H
+#define QT_BASIC_GRAPH_COMPRESSED_HISTORY_H
+
+#include "qtbasicgraphhistory.h"
+
+
+class QtBasicGraphCompressedHistory : public QtBasicGraphChunkedHistory
+{
+public:
+    explicit QtBasicGraphCompressedHistory(qreal xResolution = 1e-6, int chunkSize = 1024);
+    ~QtBasicGraphCompressedHistory();
+
+    qreal xResolution() const { return m_x_resolution; }
+    qint64 compressedSize() const { return m_compressed_size; }
+
+protected:
+    void storeChunk(const QVector<QPointF> &points);
+    const QPointF *chunk(int index) const;
+    void clearChunks();
+
+private:
+    void decode(int index, QPointF *points) const;
+
+    qreal m_x_resolution;
+    QVector<QVector<quint64> > m_chunks;
+    qint64 m_compressed_size;
+
+    // the two most recently decoded chunks
+    mutable int m_cache_index[2];
+    mutable QVector<QPointF> m_cache[2];
+    mutable int m_cache_next;
+};
+
+#endif // QT_BASIC_GRAPH_COMPRESSED_HISTORY_H
@@ -0,0 +1,148 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraphfilehistory.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QDebug>
+
+/*!
+
+    \class QtBasicGraphFileHistory qtbasicgraphfilehistory.h
+
+    \brief The QtBasicGraphFileHistory class spills the history of a
+    QtBasicGraph to a memory-mapped file.
+
+    Samples are collected in a small tail buffer in memory. As soon as the
+    tail holds \a chunkSize samples it is appended to the file and the new
+    chunk of the file is mapped into memory. All reads go through the
+    mappings without copying, so only the pages of the visible range have to
+    be resident and the operating system is free to drop the rest.
+
+    \code
+        QtBasicGraph * graph = new QtBasicGraph(this);
+        graph->setHistory(new QtBasicGraphFileHistory("/var/tmp/pressure.dat"));
+    \endcode
+
+    If no file name is given a temporary file is used, which is removed
+    together with the history. A named file is truncated when the history is
+    created and by clear(), but kept with all samples when the history is
+    destroyed.
+
+    \sa QtBasicGraph::setHistory()
+
+*/
+
+/*!
+    Creates a history that spills to \a fileName in chunks of \a chunkSize
+    samples.
+*/
+QtBasicGraphFileHistory::QtBasicGraphFileHistory(const QString &fileName, int chunkSize)
+    : QtBasicGraphChunkedHistory(chunkSize), m_file(0)
+{
+    if (fileName.isEmpty()) {
+        QTemporaryFile *file = new QTemporaryFile();
+        file->open();
+        m_file = file;
+    } else {
+        m_file = new QFile(fileName);
+        m_file->open(QIODevice::ReadWrite | QIODevice::Truncate);
+    }
+
+    if (!m_file->isOpen())
+        qWarning() << "QtBasicGraphFileHistory: cannot open" << fileName << "- keeping the history in memory.";
+}
+
+/*!
+    Destructor
+*/
+QtBasicGraphFileHistory::~QtBasicGraphFileHistory()
+{
+    // only clear() truncates, a named file keeps the recording
+    unmapChunks();
+    delete m_file;
+}
+
+/*!
+    Returns true if the spill file could be opened.
+*/
+bool QtBasicGraphFileHistory::isOpen() const
+{
+    return m_file->isOpen();
+}
+
+/*!
+    Returns the name of the spill file.
+*/
+QString QtBasicGraphFileHistory::fileName() const
+{
+    return m_file->fileName();
+}
+
+/*!
+    \internal
+    Appends \a points to the file and maps them. If that fails the chunk
+    stays in memory, so no samples are lost.
+*/
+void QtBasicGraphFileHistory::storeChunk(const QVector<QPointF> &points)
+{
+    Chunk chunk;
+    chunk.mapping = 0;
+
+    const qint64 bytes = qint64(points.size()) * sizeof(QPointF);
+    const qint64 offset = qint64(m_chunks.size()) * bytes;
+
+    if (m_file->isOpen() && m_file->seek(offset)
+        && m_file->write(reinterpret_cast<const char *>(points.constData()), bytes) == bytes
+        && m_file->flush()) {
+        chunk.mapping = m_file->map(offset, bytes);
+    }
+
+    if (!chunk.mapping)
+        chunk.memory = points;
+
+    m_chunks.append(chunk);
+}
+
+/*!
+    \internal
+    Returns the samples of the chunk \a index directly from the mapping.
+*/
+const QPointF *QtBasicGraphFileHistory::chunk(int index) const
+{
+    const Chunk &chunk = m_chunks.at(index);
+    if (chunk.mapping)
+        return reinterpret_cast<const QPointF *>(chunk.mapping);
+    return chunk.memory.constData();
+}
+
+/*!
+    \internal
+    Removes all chunks and truncates the file.
+*/
+void QtBasicGraphFileHistory::clearChunks()
+{
+    unmapChunks();
+
+    if (m_file->isOpen())
+        m_file->resize(0);
+}
+
+/*!
+    \internal
+    Unmaps and forgets all chunks, the file is left as it is.
+*/
+void QtBasicGraphFileHistory::unmapChunks()
+{
+    for (int i = 0; i < m_chunks.size(); ++i) {
+        if (m_chunks.at(i).mapping)
+            m_file->unmap(m_chunks.at(i).mapping);
+    }
+    m_chunks.clear();
+}
@@ -0,0 +1,46 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//History of QtBasicGraph spilled to a memory-mapped file.
+#ifndef QT_BASIC_GRAPH_FILE_HISTORY_H
+#define QT_BASIC_GRAPH_FILE_HISTORY_H
+
+#include "qtbasicgraphhistory.h"
+
+#include <QtCore/QString>
+
+class QFile;
+
+
+class QtBasicGraphFileHistory : public QtBasicGraphChunkedHistory
+{
+public:
+    explicit QtBasicGraphFileHistory(const QString &fileName = QString(), int chunkSize = 65536);
+    ~QtBasicGraphFileHistory();
+
+    bool isOpen() const;
+    QString fileName() const;
+
+protected:
+    void storeChunk(const QVector<QPointF> &points);
+    const QPointF *chunk(int index) const;
+    void clearChunks();
+
+private:
+    struct Chunk {
+        uchar *mapping;
+        QVector<QPointF> memory;   // only used if the chunk could not be mapped
+    };
+
+    void unmapChunks();
+
+    QFile *m_file;
+    QVector<Chunk> m_chunks;
+};
+
+#endif // QT_BASIC_GRAPH_FILE_HISTORY_H
@@ -0,0 +1,390 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraphhistory.h"
+#include "qtbasicgraphkernels.h"
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+#include <limits>
+
+/*!
+
+    \class QtBasicGraphHistory qtbasicgraphhistory.h
+
+    \brief The QtBasicGraphHistory class stores the complete sample stream of a
+    QtBasicGraph for zooming and panning.
+
+    Besides the samples the history keeps a pyramid of per-block minimum and
+    maximum values. The finest level holds one entry per 32 samples, every
+    coarser level combines 8 blocks of the level below. The pyramid is updated
+    incrementally in append(), so the extrema of any sample range are found by
+    reading at most a few blocks per level instead of every sample. This keeps
+    the cost of a paint proportional to the number of pixel columns, no matter
+    how many samples are visible.
+
+    Subclasses decide where the samples are stored, see
+    QtBasicGraphMemoryHistory for the plain in-memory storage,
+    QtBasicGraphFileHistory for a history that spills to a memory-mapped file
+    and QtBasicGraphCompressedHistory for a compressed in-memory history.
+
+*/
+
+QtBasicGraphHistory::QtBasicGraphHistory()
+{
+    m_levels.resize(1);
+}
+
+/*!
+    Destructor
+*/
+QtBasicGraphHistory::~QtBasicGraphHistory()
+{
+}
+
+/*!
+    Appends \a point. The x values have to be added in ascending order.
+*/
+void QtBasicGraphHistory::append(const QPointF &point)
+{
+    const qint64 index = count();
+    appendPoint(point);
+    updatePyramid(index, float(point.y()));
+}
+
+/*!
+    Removes all samples.
+*/
+void QtBasicGraphHistory::clear()
+{
+    clearPoints();
+    m_levels.clear();
+    m_levels.resize(1);
+}
+
+/*!
+    Copies \a count samples starting at index \a first into \a points.
+    The default implementation calls at() for every sample.
+*/
+void QtBasicGraphHistory::read(qint64 first, int count, QPointF *points) const
+{
+    for (int i = 0; i < count; ++i)
+        points[i] = at(first + i);
+}
+
+/*!
+    Returns the index of the first sample with an x value not less than \a x,
+    or count() if there is no such sample.
+*/
+qint64 QtBasicGraphHistory::lowerBound(qreal x) const
+{
+    qint64 low = 0;
+    qint64 high = count();
+
+    while (low < high) {
+        const qint64 middle = low + (high - low) / 2;
+        if (at(middle).x() < x)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/*!
+    Splits the x range from \a x0 to \a x1 into \a count equally wide columns
+    and stores the first, last, minimum and maximum y value of the samples in
+    each of them in \a columns.
+*/
+void QtBasicGraphHistory::columns(qreal x0, qreal x1, Column *columns, int count) const
+{
+    if (count <= 0)
+        return;
+
+    const qreal dx = (x1 - x0) / count;
+    qint64 first = lowerBound(x0);
+
+    for (int c = 0; c < count; ++c) {
+        const qint64 last = (c == count - 1) ? lowerBound(x1) : lowerBound(x0 + (c + 1) * dx);
+
+        Column &column = columns[c];
+        column.count = last - first;
+        if (column.count > 0) {
+            column.first = float(at(first).y());
+            column.last = float(at(last - 1).y());
+            extremum(first, last, &column.min, &column.max);
+        }
+        first = last;
+    }
+}
+
+/*!
+    \internal
+    Updates all pyramid levels with the sample \a y at \a index and adds a
+    coarser level as soon as the top level has more than one block.
+*/
+void QtBasicGraphHistory::updatePyramid(qint64 index, float y)
+{
+    qint64 span = BlockSize;
+    for (int level = 0; level < m_levels.size(); ++level, span *= LevelFactor) {
+        QVector<Extremum> &blocks = m_levels[level];
+        const int block = int(index / span);
+
+        if (block == blocks.size()) {
+            Extremum e = { y, y };
+            blocks.append(e);
+        } else {
+            Extremum &e = blocks[block];
+            e.min = qMin(e.min, y);
+            e.max = qMax(e.max, y);
+        }
+    }
+
+    const QVector<Extremum> top = m_levels.last();
+    if (top.size() > 1) {
+        QVector<Extremum> blocks;
+        for (int i = 0; i < top.size(); ++i) {
+            if (i % LevelFactor == 0) {
+                blocks.append(top.at(i));
+            } else {
+                Extremum &e = blocks.last();
+                e.min = qMin(e.min, top.at(i).min);
+                e.max = qMax(e.max, top.at(i).max);
+            }
+        }
+        m_levels.append(blocks);
+    }
+}
+
+/*!
+    \internal
+    Returns the minimum and maximum y value of the samples from index \a first
+    up to but not including \a last. Only the unaligned samples at both ends
+    are read, everything in between is taken from the coarsest pyramid level
+    that covers it completely.
+*/
+void QtBasicGraphHistory::extremum(qint64 first, qint64 last, float *min, float *max) const
+{
+    float low = std::numeric_limits<float>::max();
+    float high = -std::numeric_limits<float>::max();
+
+    QPointF buffer[BlockSize];
+
+    const qint64 head = qMin(last, (first + BlockSize - 1) / BlockSize * BlockSize);
+    if (head > first) {
+        read(first, int(head - first), buffer);
+        for (int i = 0; i < head - first; ++i) {
+            low = qMin(low, float(buffer[i].y()));
+            high = qMax(high, float(buffer[i].y()));
+        }
+        first = head;
+    }
+
+    const qint64 tail = qMax(first, last / BlockSize * BlockSize);
+    if (last > tail) {
+        read(tail, int(last - tail), buffer);
+        for (int i = 0; i < last - tail; ++i) {
+            low = qMin(low, float(buffer[i].y()));
+            high = qMax(high, float(buffer[i].y()));
+        }
+        last = tail;
+    }
+
+    qint64 a = first / BlockSize;
+    qint64 b = last / BlockSize;
+
+    for (int level = 0; a < b; ++level) {
+        const QVector<Extremum> &blocks = m_levels.at(level);
+        const bool top = (level + 1 == m_levels.size());
+
+        while (a < b && (top || a % LevelFactor)) {
+            low = qMin(low, blocks.at(int(a)).min);
+            high = qMax(high, blocks.at(int(a)).max);
+            ++a;
+        }
+        while (a < b && b % LevelFactor) {
+            --b;
+            low = qMin(low, blocks.at(int(b)).min);
+            high = qMax(high, blocks.at(int(b)).max);
+        }
+
+        a /= LevelFactor;
+        b /= LevelFactor;
+    }
+
+    *min = low;
+    *max = high;
+}
+
+
+/*!
+
+    \class QtBasicGraphMemoryHistory qtbasicgraphhistory.h
+
+    \brief The QtBasicGraphMemoryHistory class keeps the history of a
+    QtBasicGraph in memory.
+
+*/
+
+QtBasicGraphMemoryHistory::QtBasicGraphMemoryHistory()
+{
+}
+
+/*!
+    Destructor
+*/
+QtBasicGraphMemoryHistory::~QtBasicGraphMemoryHistory()
+{
+}
+
+qint64 QtBasicGraphMemoryHistory::count() const
+{
+    return m_points.size();
+}
+
+QPointF QtBasicGraphMemoryHistory::at(qint64 index) const
+{
+    return m_points.at(int(index));
+}
+
+void QtBasicGraphMemoryHistory::read(qint64 first, int count, QPointF *points) const
+{
+    std::copy(m_points.constBegin() + first, m_points.constBegin() + first + count, points);
+}
+
+qint64 QtBasicGraphMemoryHistory::lowerBound(qreal x) const
+{
+    return std::lower_bound(m_points.constBegin(), m_points.constEnd(), x, QtBasicGraphLessX()) - m_points.constBegin();
+}
+
+void QtBasicGraphMemoryHistory::appendPoint(const QPointF &point)
+{
+    m_points.append(point);
+}
+
+void QtBasicGraphMemoryHistory::clearPoints()
+{
+    m_points.clear();
+}
+
+
+/*!
+
+    \class QtBasicGraphChunkedHistory qtbasicgraphhistory.h
+
+    \brief The QtBasicGraphChunkedHistory class is the base of histories that
+    move older samples out of a plain memory buffer in chunks.
+
+    New samples are collected in a tail buffer. Whenever the tail holds
+    chunkSize() samples it is passed to storeChunk() and emptied. Subclasses
+    return the samples of a stored chunk from chunk(); the returned pointer
+    only has to stay valid until the next call of chunk().
+
+*/
+
+/*!
+    Creates a history that stores chunks of \a chunkSize samples.
+*/
+QtBasicGraphChunkedHistory::QtBasicGraphChunkedHistory(int chunkSize)
+    : m_chunk_size(qMax(chunkSize, 64))
+{
+    m_tail.reserve(m_chunk_size);
+}
+
+/*!
+    Destructor
+*/
+QtBasicGraphChunkedHistory::~QtBasicGraphChunkedHistory()
+{
+}
+
+qint64 QtBasicGraphChunkedHistory::count() const
+{
+    return qint64(chunkCount()) * m_chunk_size + m_tail.size();
+}
+
+QPointF QtBasicGraphChunkedHistory::at(qint64 index) const
+{
+    int available;
+    return *data(index, &available);
+}
+
+void QtBasicGraphChunkedHistory::read(qint64 first, int count, QPointF *points) const
+{
+    while (count > 0) {
+        int available;
+        const QPointF *source = data(first, &available);
+        if (available <= 0) {
+            qWarning() << "QtBasicGraphChunkedHistory::read: index" << first << "is out of range.";
+            break;
+        }
+        available = qMin(available, count);
+
+        std::copy(source, source + available, points);
+        points += available;
+        first += available;
+        count -= available;
+    }
+}
+
+qint64 QtBasicGraphChunkedHistory::lowerBound(qreal x) const
+{
+    // number of stored chunks starting before x
+    const int chunks = std::lower_bound(m_first_x.constBegin(), m_first_x.constEnd(), x) - m_first_x.constBegin();
+
+    if (chunks > 0) {
+        // search the last chunk starting before x, only if all of its
+        // samples are less than x the result is in the following chunk
+        const QPointF *points = chunk(chunks - 1);
+        const QPointF *found = std::lower_bound(points, points + m_chunk_size, x, QtBasicGraphLessX());
+        if (found != points + m_chunk_size || chunks < chunkCount())
+            return qint64(chunks - 1) * m_chunk_size + (found - points);
+    } else if (chunkCount() > 0) {
+        return 0;
+    }
+
+    const qint64 stored = qint64(chunkCount()) * m_chunk_size;
+    return stored + (std::lower_bound(m_tail.constBegin(), m_tail.constEnd(), x, QtBasicGraphLessX()) - m_tail.constBegin());
+}
+
+/*!
+    Returns a pointer to the samples starting at index \a first. The number
+    of samples that can be read contiguously from the pointer is stored in
+    \a count. The pointer is valid until the next call.
+*/
+const QPointF *QtBasicGraphChunkedHistory::data(qint64 first, int *count) const
+{
+    const int index = int(first / m_chunk_size);
+    const int offset = int(first - qint64(index) * m_chunk_size);
+
+    if (index < chunkCount()) {
+        *count = m_chunk_size - offset;
+        return chunk(index) + offset;
+    }
+
+    *count = qMax(0, m_tail.size() - offset);
+    return m_tail.constData() + offset;
+}
+
+void QtBasicGraphChunkedHistory::appendPoint(const QPointF &point)
+{
+    m_tail.append(point);
+    if (m_tail.size() == m_chunk_size) {
+        m_first_x.append(m_tail.first().x());
+        storeChunk(m_tail);
+        m_tail.resize(0);
+    }
+}
+
+void QtBasicGraphChunkedHistory::clearPoints()
+{
+    clearChunks();
+    m_first_x.clear();
+    m_tail.resize(0);
+}
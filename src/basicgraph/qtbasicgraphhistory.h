@@ -0,0 +1,121 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Long term sample storage of QtBasicGraph with a min/max pyramid.
+#ifndef QT_BASIC_GRAPH_HISTORY_H
+#define QT_BASIC_GRAPH_HISTORY_H
+
+#include <QtCore/QPointF>
+#include <QtCore/QVector>
+
+
+class QtBasicGraphHistory
+{
+public:
+    // first, last, minimum and maximum y value of the samples in one
+    // pixel column, count is 0 for columns without samples
+    struct Column {
+        qint64 count;
+        float first;
+        float last;
+        float min;
+        float max;
+    };
+
+    QtBasicGraphHistory();
+    virtual ~QtBasicGraphHistory();
+
+    void append(const QPointF &point);
+    void clear();
+
+    virtual qint64 count() const = 0;
+    virtual QPointF at(qint64 index) const = 0;
+    virtual void read(qint64 first, int count, QPointF *points) const;
+    virtual qint64 lowerBound(qreal x) const;
+
+    bool isEmpty() const { return count() == 0; }
+    qreal firstX() const { return at(0).x(); }
+    qreal lastX() const  { return at(count() - 1).x(); }
+
+    void columns(qreal x0, qreal x1, Column *columns, int count) const;
+
+protected:
+    virtual void appendPoint(const QPointF &point) = 0;
+    virtual void clearPoints() = 0;
+
+private:
+    struct Extremum {
+        float min;
+        float max;
+    };
+
+    enum {
+        BlockSize = 32,   // samples per block on the finest level
+        LevelFactor = 8   // blocks per block of the next coarser level
+    };
+
+    void updatePyramid(qint64 index, float y);
+    void extremum(qint64 first, qint64 last, float *min, float *max) const;
+
+    QVector<QVector<Extremum> > m_levels;
+
+    Q_DISABLE_COPY(QtBasicGraphHistory)
+};
+
+
+class QtBasicGraphMemoryHistory : public QtBasicGraphHistory
+{
+public:
+    QtBasicGraphMemoryHistory();
+    ~QtBasicGraphMemoryHistory();
+
+    qint64 count() const;
+    QPointF at(qint64 index) const;
+    void read(qint64 first, int count, QPointF *points) const;
+    qint64 lowerBound(qreal x) const;
+
+protected:
+    void appendPoint(const QPointF &point);
+    void clearPoints();
+
+private:
+    QVector<QPointF> m_points;
+};
+
+
+class QtBasicGraphChunkedHistory : public QtBasicGraphHistory
+{
+public:
+    explicit QtBasicGraphChunkedHistory(int chunkSize);
+    ~QtBasicGraphChunkedHistory();
+
+    qint64 count() const;
+    QPointF at(qint64 index) const;
+    void read(qint64 first, int count, QPointF *points) const;
+    qint64 lowerBound(qreal x) const;
+
+    const QPointF *data(qint64 first, int *count) const;
+
+    int chunkSize() const  { return m_chunk_size; }
+    int chunkCount() const { return m_first_x.size(); }
+
+protected:
+    void appendPoint(const QPointF &point);
+    void clearPoints();
+
+    virtual void storeChunk(const QVector<QPointF> &points) = 0;
+    virtual const QPointF *chunk(int index) const = 0;
+    virtual void clearChunks() = 0;
+
+private:
+    int m_chunk_size;
+    QVector<qreal> m_first_x;
+    QVector<QPointF> m_tail;
+};
+
+#endif // QT_BASIC_GRAPH_HISTORY_H
@@ -0,0 +1,509 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+#include "qtbasicgraphhistory.h"
+#include "qtbasicgraphkernels.h"
+
+#include <algorithm>
+#include <limits>
+
+/*!
+    Returns the number of samples held for the visible range.
+*/
+int QtBasicGraph::sampleCount() const
+{
+    if (isFixedRate())
+        return m_samples.size() - m_sample_offset;
+    return m_values.size() - m_value_offset;
+}
+
+/*!
+    Adds the point \a value. In fixed-rate mode only the x value of the first
+    point is used, it defines the x value of the sample at index 0.
+*/
+void QtBasicGraph::addPoint(const QPointF &value)
+{
+    if (isFixedRate()) {
+        if (sampleCount() == 0) {
+            m_origin_x = value.x();
+            m_first_sample = 0;
+        }
+        addSample(value.y());
+        return;
+    }
+
+    QPointF oldval;
+
+    if (sampleCount() > 0)
+        oldval = m_values.last();
+
+    if (!oldval.isNull() && value.x() < oldval.x()) {
+        qWarning("QtBasicGraph::addPoint(): the new point's x value is less than the last point's x value.");
+        return; 
+    }
+
+    m_values.append(value);
+
+    if (m_history)
+        m_history->append(value);
+
+    // the window of a shown model source is tracked instead
+    if (!m_source && (m_auto_range || m_statistics))
+        trackRange(firstSerial() + sampleCount() - 1, float(value.y()));
+
+    if (!m_source && m_trigger_mode != NoTrigger)
+        updateTrigger();
+
+    if (!oldval.isNull()) {
+        purge(value.x() - m_xrange);
+        advance(value.x() - oldval.x());
+    }
+
+    if (m_statistics)
+        scheduleStatistics();
+}
+
+/*!
+    Adds the sample \a y in fixed-rate mode.
+*/
+void QtBasicGraph::addSample(qreal y)
+{
+    const float value = y;
+    addSamples(&value, 1);
+}
+
+/*!
+    Adds \a count samples from the array \a y in fixed-rate mode. The widget
+    is scrolled and old data is purged once for the whole block.
+*/
+void QtBasicGraph::addSamples(const float *y, int count)
+{
+    if (!isFixedRate()) {
+        qWarning("QtBasicGraph::addSamples(): no sample interval set, use addPoint() for irregular data.");
+        return;
+    }
+
+    if (count <= 0)
+        return;
+
+    const int steps = sampleCount() > 0 ? count : count - 1;
+    const int size = m_samples.size();
+    m_samples.resize(size + count);
+    std::copy(y, y + count, m_samples.begin() + size);
+
+    const int index = size - m_sample_offset;
+
+    if (m_history) {
+        for (int i = 0; i < count; ++i)
+            m_history->append(QPointF(sampleX(index + i), y[i]));
+    }
+
+    if (!m_source && (m_auto_range || m_statistics)) {
+        const qint64 serial = firstSerial() + index;
+        for (int i = 0; i < count; ++i)
+            trackRange(serial + i, y[i]);
+    }
+
+    if (!m_source && m_trigger_mode != NoTrigger)
+        updateTrigger();
+
+    if (steps > 0) {
+        purge(lastX() - m_xrange);
+        advance(steps * m_sample_interval);
+    }
+
+    if (m_statistics)
+        scheduleStatistics();
+}
+
+void QtBasicGraph::clear()
+{
+    m_values.clear();
+    m_value_offset = 0;
+    m_samples.clear();
+    m_sample_offset = 0;
+    m_first_sample = 0;
+    m_origin_x = 0;
+    m_purged_values = 0;
+    m_range_min.clear();
+    m_range_max.clear();
+    m_stats_count = 0;
+    m_stats_mean = 0;
+    m_stats_m2 = 0;
+    if (m_statistics)
+        scheduleStatistics();
+    m_annotations.clear();
+    m_capture_valid = false;
+    m_capture.clear();
+    armTrigger();
+    m_scroll_error = 0;
+    if (m_history)
+        m_history->clear();
+    m_follow = true;
+    invalidate();
+}
+
+/*!
+    \internal
+    Updates the view after new data moved the newest x value by \a dx.
+    A changed auto range needs a full repaint, otherwise the view is
+    scrolled if it follows the incoming data.
+*/
+void QtBasicGraph::advance(qreal dx)
+{
+    if (updateAutoRange()) {
+        m_scroll_error = 0;
+        invalidate();
+    } else if (m_follow && !showsCapture()) {
+        scrollBy(dx);
+    }
+}
+
+/*!
+    \internal
+    Rows appended to the source are tracked and scroll the view like
+    addPoint(), all other insertions only repaint the columns between their
+    neighbours.
+*/
+void QtBasicGraph::sourceInserted(int first, int count)
+{
+    const int total = m_source->count();
+
+    if (first + count < total) {
+        // the rows behind the inserted ones are renumbered
+        rebuildSource();
+        updateSourceRange(first - 1, first + count);
+        return;
+    }
+
+    if ((m_auto_range || m_statistics) && m_source->seriesCount() > 0) {
+        for (int row = first; row < total; ++row)
+            trackSourceRow(row);
+    }
+
+    if (m_trigger_mode != NoTrigger)
+        updateTrigger();
+
+    purgeSource(m_source->lastX() - m_xrange);
+
+    if (!m_follow) {
+        updateSourceRange(first - 1, total);
+    } else if (first > 0) {
+        advance(m_source->lastX() - m_source->x()[first - 1]);
+    } else {
+        updateAutoRange();
+        m_scroll_error = 0;
+        invalidate();
+    }
+
+    if (m_statistics)
+        scheduleStatistics();
+}
+
+/*!
+    \internal
+    Removes the rows of the live window that are about to be removed from
+    the front of the source from the statistics while they can still be
+    read.
+*/
+void QtBasicGraph::sourceAboutToBeRemoved(int first, int count)
+{
+    if (first == 0 && count < m_source->count() && count > m_source_first)
+        untrackRange(count - m_source_first);
+}
+
+/*!
+    \internal
+    Rows removed from the front, the oldest rows of a streaming model, only
+    move the live window, removing other rows starts it again.
+*/
+void QtBasicGraph::sourceRemoved(int first, int count)
+{
+    if (first == 0 && m_source->count() > 0) {
+        m_source_removed += count;
+        m_source_first = qMax(0, m_source_first - count);
+        dropRange();
+        if (m_statistics)
+            scheduleStatistics();
+        updateSourceRange(-1, 0);
+        return;
+    }
+
+    rebuildSource();
+
+    // removing the newest rows moves the right edge of a following view
+    if (first == m_source->count() && m_follow) {
+        updateAutoRange();
+        m_scroll_error = 0;
+        invalidate();
+        return;
+    }
+    updateSourceRange(first - 1, first);
+}
+
+void QtBasicGraph::sourceChanged(int first, int count)
+{
+    // rows left of the live window are only shown
+    if (first + count > m_source_first)
+        rebuildSource();
+
+    if (first + count == m_source->count() && m_follow) {
+        updateAutoRange();
+        m_scroll_error = 0;
+        invalidate();
+        return;
+    }
+    updateSourceRange(first - 1, first + count);
+}
+
+void QtBasicGraph::sourceReset()
+{
+    // also called for a destroyed source, m_source is already 0 then
+    rebuildSource();
+    updateAutoRange();
+    m_scroll_error = 0;
+    invalidate();
+}
+
+/*!
+    \internal
+    Repaints the part of the view between the source samples at \a first
+    and \a last. An index before the first sample stands for the left, one
+    after the last sample for the right edge of the view. The whole view is
+    repainted if the auto range changed.
+*/
+void QtBasicGraph::updateSourceRange(int first, int last)
+{
+    const int count = m_source->count();
+    if (count == 0 || updateAutoRange()) {
+        m_scroll_error = 0;
+        invalidate();
+        return;
+    }
+
+    const qreal *x = m_source->x();
+    const qreal x0 = first < 0 ? -std::numeric_limits<qreal>::max() : x[qMin(first, count - 1)];
+    const qreal x1 = last >= count ? std::numeric_limits<qreal>::max() : x[qMax(last, 0)];
+    updateX(x0, x1);
+}
+
+/*!
+    \internal
+    Adds the source row \a row to the auto range, which covers all traces,
+    and to the statistics and the trigger, which only use the first trace.
+*/
+void QtBasicGraph::trackSourceRow(int row)
+{
+    const qint64 serial = m_source_removed + row;
+    trackRange(serial, m_source->y(0)[row]);
+    for (int s = 1; s < m_source->seriesCount(); ++s)
+        trackExtremes(serial, m_source->y(s)[row]);
+}
+
+/*!
+    \internal
+    Moves the start of the live window of the source to the last row at or
+    before \a left. Unlike purge() the rows stay in the source, they only
+    leave the auto range and the statistics.
+*/
+void QtBasicGraph::purgeSource(qreal left)
+{
+    const qreal *x = m_source->x();
+    const int count = m_source->count();
+    const int i = qMin(int(std::upper_bound(x + m_source_first, x + count, left) - x) - 1, count - 2);
+
+    if (i > m_source_first) {
+        untrackRange(i - m_source_first);
+        m_source_first = i;
+        dropRange();
+    }
+}
+
+/*!
+    \internal
+    Starts the live window of the source at the last row at or before
+    xRange() left of the newest one, then fills the auto range and the
+    statistics again from its rows. Called whenever rows of the source were
+    renumbered or changed, and when the source is set or removed.
+*/
+void QtBasicGraph::rebuildSource()
+{
+    m_source_first = 0;
+    if (m_source && m_source->count() > 0) {
+        const qreal *x = m_source->x();
+        const int count = m_source->count();
+        const qreal left = m_source->lastX() - m_xrange;
+        m_source_first = qMax(0, int(std::upper_bound(x, x + count, left) - x) - 1);
+    }
+
+    rebuildRange();
+    if (m_statistics)
+        scheduleStatistics();
+
+    // the trigger search starts again behind the newest row
+    if (m_trigger_armed || m_trigger_pending)
+        armTrigger();
+}
+
+/*!
+    \internal
+    Repaints the pixel columns showing the x values from \a x0 to \a x1.
+*/
+void QtBasicGraph::updateX(qreal x0, qreal x1)
+{
+    const qreal scalex = width() / m_view_range;
+    const qreal left = viewRight() - m_view_range;
+    const qreal limit = width() + 4;
+
+    const int a = qFloor(qBound(qreal(-4), (x0 - left) * scalex, limit));
+    const int b = qCeil(qBound(qreal(-4), (x1 - left) * scalex, limit));
+
+    // the lines into the range end up to 3 pixels outside of it
+    const QRect dirty = QRect(a - 3, 0, b - a + 7, height()) & rect();
+    if (dirty.isEmpty())
+        return;
+
+    m_trace_dirty |= dirty;
+    update(dirty);
+}
+
+/*!
+    \internal
+    Removes all data left of \a left except the last point before it,
+    which is needed to draw the line into the visible area.
+*/
+void QtBasicGraph::purge(qreal left)
+{
+    // keep the shown capture before its samples leave the live window
+    if (showsCapture() && m_capture.isEmpty() && left > m_capture_right - m_view_range)
+        copyCapture();
+
+    // the history still shows older annotations, and so does a capture
+    if (!m_history)
+        m_annotations.purge(showsCapture() ? qMin(left, m_capture_right - m_view_range) : left);
+
+    if (isFixedRate()) {
+        int i = qMin(qFloor((left - sampleX(0)) / m_sample_interval), sampleCount() - 2);
+        if (i <= 0)
+            return;
+
+        // the window of a shown model source is tracked instead
+        if (!m_source)
+            untrackRange(i);
+        m_sample_offset += i;
+        m_first_sample += i;
+
+        // compact lazily, so purging stays amortized O(1) per sample
+        if (m_sample_offset > m_samples.size() / 2) {
+            m_samples.remove(0, m_sample_offset);
+            m_sample_offset = 0;
+            if (m_statistics)
+                rebuildRange();
+        }
+        dropRange();
+        return;
+    }
+
+    // keep the last point at or before left
+    const QPointF *first = values();
+    int i = std::upper_bound(first, first + sampleCount(), left, QtBasicGraphLessX()) - first;
+    i--;
+
+    if (i > 0 && i < (sampleCount() - 1)) {
+        if (!m_source)
+            untrackRange(i);
+        m_value_offset += i;
+        m_purged_values += i;
+
+        if (m_value_offset > m_values.size() / 2) {
+            m_values.remove(0, m_value_offset);
+            m_value_offset = 0;
+            if (m_statistics)
+                rebuildRange();
+        }
+        dropRange();
+    }
+}
+
+/*!
+    \internal
+    Returns the running number of the oldest sample in the live window.
+*/
+qint64 QtBasicGraph::firstSerial() const
+{
+    if (m_source)
+        return m_source_removed + m_source_first;
+    return isFixedRate() ? m_first_sample : m_purged_values;
+}
+
+/*!
+    \internal
+    Returns the x value of the fixed-rate sample at \a index.
+*/
+qreal QtBasicGraph::sampleX(int index) const
+{
+    return m_origin_x + (m_first_sample + index) * m_sample_interval;
+}
+
+/*!
+    \internal
+    Returns the live sample at \a index as a point.
+*/
+QPointF QtBasicGraph::liveSample(int index) const
+{
+    if (m_source)
+        return m_source->point(0, m_source_first + index);
+    if (isFixedRate())
+        return QPointF(sampleX(index), samples()[index]);
+    return values()[index];
+}
+
+/*!
+    \internal
+    Returns the x value of the newest sample.
+*/
+qreal QtBasicGraph::lastX() const
+{
+    if (m_source)
+        return m_source->lastX();
+    if (isFixedRate())
+        return sampleX(sampleCount() - 1);
+    return sampleCount() == 0 ? qreal(0) : m_values.last().x();
+}
+
+/*!
+    \internal
+    Returns the index of the first live sample with an x value not less
+    than \a x, or liveCount() if there is none.
+*/
+int QtBasicGraph::lowerBound(qreal x) const
+{
+    if (m_source)
+        return qMax(0, m_source->lowerBound(x) - m_source_first);
+
+    const int count = sampleCount();
+
+    if (isFixedRate())
+        return qBound(0, qCeil((x - sampleX(0)) / m_sample_interval), count);
+
+    const QPointF *first = values();
+    return std::lower_bound(first, first + count, x, QtBasicGraphLessX()) - first;
+}
+
+/*!
+    \internal
+    Returns the number of samples in the live window, for a model source
+    the number of rows from the start of its window on.
+*/
+int QtBasicGraph::liveCount() const
+{
+    if (m_source)
+        return m_source->seriesCount() > 0 ? m_source->count() - m_source_first : 0;
+    return sampleCount();
+}
@@ -0,0 +1,701 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraphkernels.h"
+
+#include <QtCore/QtAlgorithms>
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+#include <limits>
+
+// The kernels are selected at compile time. SSE2 is always available on
+// x86-64, the AVX2 variants are used when the library is built with AVX2
+// enabled (e.g. QMAKE_CXXFLAGS += -mavx2). All other targets use the
+// scalar loops, which compilers vectorize on their own where they can.
+#if defined(__AVX2__)
+#  define QT_BASIC_GRAPH_AVX2
+#  include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define QT_BASIC_GRAPH_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(QT_BASIC_GRAPH_AVX2) || defined(QT_BASIC_GRAPH_SSE2)
+// the vector paths read and write QPointF as pairs of doubles
+Q_STATIC_ASSERT(sizeof(QPointF) == 2 * sizeof(double) && sizeof(qreal) == sizeof(double));
+#endif
+
+void qtBasicGraphMapPoints(const QPointF *points, int count,
+                           qreal x0, qreal y0, qreal sx, qreal sy, QPointF *out)
+{
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    const double *src = reinterpret_cast<const double *>(points);
+    double *dst = reinterpret_cast<double *>(out);
+    const __m256d offset = _mm256_set_pd(y0, x0, y0, x0);
+    const __m256d scale = _mm256_set_pd(sy, sx, sy, sx);
+    for (; i + 2 <= count; i += 2) {
+        const __m256d p = _mm256_loadu_pd(src + 2 * i);
+        _mm256_storeu_pd(dst + 2 * i, _mm256_mul_pd(_mm256_sub_pd(p, offset), scale));
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    const double *src = reinterpret_cast<const double *>(points);
+    double *dst = reinterpret_cast<double *>(out);
+    const __m128d offset = _mm_set_pd(y0, x0);
+    const __m128d scale = _mm_set_pd(sy, sx);
+    for (; i < count; ++i) {
+        const __m128d p = _mm_loadu_pd(src + 2 * i);
+        _mm_storeu_pd(dst + 2 * i, _mm_mul_pd(_mm_sub_pd(p, offset), scale));
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = QPointF((points[i].x() - x0) * sx, (points[i].y() - y0) * sy);
+}
+
+void qtBasicGraphMapSamples(const float *y, int count,
+                            qreal x, qreal dx, qreal y0, qreal sy, QPointF *out)
+{
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    double *dst = reinterpret_cast<double *>(out);
+    const __m256d offset = _mm256_set1_pd(y0);
+    const __m256d scale = _mm256_set1_pd(sy);
+    const __m256d steps = _mm256_set_pd(3 * dx, 2 * dx, dx, 0);
+    for (; i + 4 <= count; i += 4) {
+        const __m256d ys = _mm256_mul_pd(_mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(y + i)), offset), scale);
+        const __m256d xs = _mm256_add_pd(_mm256_set1_pd(x + i * dx), steps);
+        const __m256d even = _mm256_unpacklo_pd(xs, ys);   // x0 y0 x2 y2
+        const __m256d odd = _mm256_unpackhi_pd(xs, ys);    // x1 y1 x3 y3
+        _mm256_storeu_pd(dst + 2 * i, _mm256_permute2f128_pd(even, odd, 0x20));
+        _mm256_storeu_pd(dst + 2 * i + 4, _mm256_permute2f128_pd(even, odd, 0x31));
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    double *dst = reinterpret_cast<double *>(out);
+    const __m128d offset = _mm_set1_pd(y0);
+    const __m128d scale = _mm_set1_pd(sy);
+    const __m128d steps01 = _mm_set_pd(dx, 0);
+    const __m128d steps23 = _mm_set_pd(3 * dx, 2 * dx);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_loadu_ps(y + i);
+        const __m128d ylo = _mm_mul_pd(_mm_sub_pd(_mm_cvtps_pd(v), offset), scale);
+        const __m128d yhi = _mm_mul_pd(_mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), offset), scale);
+        const __m128d base = _mm_set1_pd(x + i * dx);
+        const __m128d xlo = _mm_add_pd(base, steps01);
+        const __m128d xhi = _mm_add_pd(base, steps23);
+        _mm_storeu_pd(dst + 2 * i, _mm_unpacklo_pd(xlo, ylo));
+        _mm_storeu_pd(dst + 2 * i + 2, _mm_unpackhi_pd(xlo, ylo));
+        _mm_storeu_pd(dst + 2 * i + 4, _mm_unpacklo_pd(xhi, yhi));
+        _mm_storeu_pd(dst + 2 * i + 6, _mm_unpackhi_pd(xhi, yhi));
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = QPointF(x + i * dx, (y[i] - y0) * sy);
+}
+
+void qtBasicGraphMapSamples(const qreal *x, const float *y, int count,
+                            qreal x0, qreal y0, qreal sx, qreal sy, QPointF *out)
+{
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    double *dst = reinterpret_cast<double *>(out);
+    const __m256d xoffset = _mm256_set1_pd(x0);
+    const __m256d xscale = _mm256_set1_pd(sx);
+    const __m256d yoffset = _mm256_set1_pd(y0);
+    const __m256d yscale = _mm256_set1_pd(sy);
+    for (; i + 4 <= count; i += 4) {
+        const __m256d xs = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(x + i), xoffset), xscale);
+        const __m256d ys = _mm256_mul_pd(_mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(y + i)), yoffset), yscale);
+        const __m256d even = _mm256_unpacklo_pd(xs, ys);   // x0 y0 x2 y2
+        const __m256d odd = _mm256_unpackhi_pd(xs, ys);    // x1 y1 x3 y3
+        _mm256_storeu_pd(dst + 2 * i, _mm256_permute2f128_pd(even, odd, 0x20));
+        _mm256_storeu_pd(dst + 2 * i + 4, _mm256_permute2f128_pd(even, odd, 0x31));
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    double *dst = reinterpret_cast<double *>(out);
+    const __m128d xoffset = _mm_set1_pd(x0);
+    const __m128d xscale = _mm_set1_pd(sx);
+    const __m128d yoffset = _mm_set1_pd(y0);
+    const __m128d yscale = _mm_set1_pd(sy);
+    for (; i + 2 <= count; i += 2) {
+        const __m128d xs = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(x + i), xoffset), xscale);
+        const __m128 v = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + i)));
+        const __m128d ys = _mm_mul_pd(_mm_sub_pd(_mm_cvtps_pd(v), yoffset), yscale);
+        _mm_storeu_pd(dst + 2 * i, _mm_unpacklo_pd(xs, ys));
+        _mm_storeu_pd(dst + 2 * i + 2, _mm_unpackhi_pd(xs, ys));
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = QPointF((x[i] - x0) * sx, (y[i] - y0) * sy);
+}
+
+void qtBasicGraphMinMax(const float *y, int count, float *min, float *max)
+{
+    float low = y[0];
+    float high = y[0];
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    if (count >= 8) {
+        __m256 vlow = _mm256_loadu_ps(y);
+        __m256 vhigh = vlow;
+        for (i = 8; i + 8 <= count; i += 8) {
+            const __m256 v = _mm256_loadu_ps(y + i);
+            vlow = _mm256_min_ps(vlow, v);
+            vhigh = _mm256_max_ps(vhigh, v);
+        }
+        float l[8], h[8];
+        _mm256_storeu_ps(l, vlow);
+        _mm256_storeu_ps(h, vhigh);
+        for (int j = 0; j < 8; ++j) {
+            low = qMin(low, l[j]);
+            high = qMax(high, h[j]);
+        }
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    if (count >= 4) {
+        __m128 vlow = _mm_loadu_ps(y);
+        __m128 vhigh = vlow;
+        for (i = 4; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(y + i);
+            vlow = _mm_min_ps(vlow, v);
+            vhigh = _mm_max_ps(vhigh, v);
+        }
+        float l[4], h[4];
+        _mm_storeu_ps(l, vlow);
+        _mm_storeu_ps(h, vhigh);
+        for (int j = 0; j < 4; ++j) {
+            low = qMin(low, l[j]);
+            high = qMax(high, h[j]);
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        low = qMin(low, y[i]);
+        high = qMax(high, y[i]);
+    }
+
+    *min = low;
+    *max = high;
+}
+
+void qtBasicGraphMinMax(const QPointF *points, int count, qreal *min, qreal *max)
+{
+    qreal low = points[0].y();
+    qreal high = points[0].y();
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2) || defined(QT_BASIC_GRAPH_SSE2)
+    if (count >= 2) {
+        const double *src = reinterpret_cast<const double *>(points);
+        __m128d vlow = _mm_unpackhi_pd(_mm_loadu_pd(src), _mm_loadu_pd(src + 2));
+        __m128d vhigh = vlow;
+        for (i = 2; i + 2 <= count; i += 2) {
+            const __m128d v = _mm_unpackhi_pd(_mm_loadu_pd(src + 2 * i), _mm_loadu_pd(src + 2 * i + 2));
+            vlow = _mm_min_pd(vlow, v);
+            vhigh = _mm_max_pd(vhigh, v);
+        }
+        double l[2], h[2];
+        _mm_storeu_pd(l, vlow);
+        _mm_storeu_pd(h, vhigh);
+        low = qMin(l[0], l[1]);
+        high = qMax(h[0], h[1]);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        low = qMin(low, points[i].y());
+        high = qMax(high, points[i].y());
+    }
+
+    *min = low;
+    *max = high;
+}
+
+int qtBasicGraphFindCrossing(const float *y, int count, float level, bool rising)
+{
+    int i = 1;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    const __m256 vlevel = _mm256_set1_ps(level);
+    for (; i + 8 <= count; i += 8) {
+        const __m256 before = _mm256_loadu_ps(y + i - 1);
+        const __m256 after = _mm256_loadu_ps(y + i);
+        const __m256 hit = rising
+            ? _mm256_and_ps(_mm256_cmp_ps(before, vlevel, _CMP_LT_OQ), _mm256_cmp_ps(after, vlevel, _CMP_GE_OQ))
+            : _mm256_and_ps(_mm256_cmp_ps(before, vlevel, _CMP_GT_OQ), _mm256_cmp_ps(after, vlevel, _CMP_LE_OQ));
+        const int mask = _mm256_movemask_ps(hit);
+        if (mask)
+            return i + qCountTrailingZeroBits(uint(mask));
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    const __m128 vlevel = _mm_set1_ps(level);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 before = _mm_loadu_ps(y + i - 1);
+        const __m128 after = _mm_loadu_ps(y + i);
+        const __m128 hit = rising
+            ? _mm_and_ps(_mm_cmplt_ps(before, vlevel), _mm_cmpge_ps(after, vlevel))
+            : _mm_and_ps(_mm_cmpgt_ps(before, vlevel), _mm_cmple_ps(after, vlevel));
+        const int mask = _mm_movemask_ps(hit);
+        if (mask)
+            return i + qCountTrailingZeroBits(uint(mask));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (rising ? (y[i - 1] < level && y[i] >= level) : (y[i - 1] > level && y[i] <= level))
+            return i;
+    }
+    return -1;
+}
+
+int qtBasicGraphFindCrossing(const QPointF *points, int count, qreal level, bool rising)
+{
+    int i = 1;
+
+#if defined(QT_BASIC_GRAPH_AVX2) || defined(QT_BASIC_GRAPH_SSE2)
+    const double *src = reinterpret_cast<const double *>(points);
+    const __m128d vlevel = _mm_set1_pd(level);
+    for (; i + 3 <= count; i += 2) {
+        const __m128d a = _mm_loadu_pd(src + 2 * i - 2);
+        const __m128d b = _mm_loadu_pd(src + 2 * i);
+        const __m128d c = _mm_loadu_pd(src + 2 * i + 2);
+        const __m128d before = _mm_unpackhi_pd(a, b);   // y[i - 1] y[i]
+        const __m128d after = _mm_unpackhi_pd(b, c);    // y[i] y[i + 1]
+        const __m128d hit = rising
+            ? _mm_and_pd(_mm_cmplt_pd(before, vlevel), _mm_cmpge_pd(after, vlevel))
+            : _mm_and_pd(_mm_cmpgt_pd(before, vlevel), _mm_cmple_pd(after, vlevel));
+        const int mask = _mm_movemask_pd(hit);
+        if (mask)
+            return i + ((mask & 1) ? 0 : 1);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const qreal before = points[i - 1].y();
+        const qreal after = points[i].y();
+        if (rising ? (before < level && after >= level) : (before > level && after <= level))
+            return i;
+    }
+    return -1;
+}
+
+void qtBasicGraphAccumulate(float *intensity, const float *hits, int count, float decay)
+{
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    const __m256 vdecay = _mm256_set1_ps(decay);
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_mul_ps(_mm256_loadu_ps(intensity + i), vdecay);
+        _mm256_storeu_ps(intensity + i, _mm256_add_ps(v, _mm256_loadu_ps(hits + i)));
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    const __m128 vdecay = _mm_set1_ps(decay);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_mul_ps(_mm_loadu_ps(intensity + i), vdecay);
+        _mm_storeu_ps(intensity + i, _mm_add_ps(v, _mm_loadu_ps(hits + i)));
+    }
+#endif
+
+    for (; i < count; ++i)
+        intensity[i] = intensity[i] * decay + hits[i];
+}
+
+void qtBasicGraphDecay(float *intensity, int count, float decay)
+{
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    const __m256 vdecay = _mm256_set1_ps(decay);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(intensity + i, _mm256_mul_ps(_mm256_loadu_ps(intensity + i), vdecay));
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    const __m128 vdecay = _mm_set1_ps(decay);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(intensity + i, _mm_mul_ps(_mm_loadu_ps(intensity + i), vdecay));
+#endif
+
+    for (; i < count; ++i)
+        intensity[i] *= decay;
+}
+
+void qtBasicGraphMapIntensity(const float *intensity, int count, float scale,
+                              const quint32 *lut, int size, quint32 *out)
+{
+    const float last = float(size - 1);
+    int i = 0;
+
+#if defined(QT_BASIC_GRAPH_AVX2)
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vlast = _mm256_set1_ps(last);
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(intensity + i), vscale), vlast);
+        const __m256i index = _mm256_cvttps_epi32(v);
+        const __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), index, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), colors);
+    }
+#elif defined(QT_BASIC_GRAPH_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vlast = _mm_set1_ps(last);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(intensity + i), vscale), vlast);
+        int index[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(index), _mm_cvttps_epi32(v));
+        out[i] = lut[index[0]];
+        out[i + 1] = lut[index[1]];
+        out[i + 2] = lut[index[2]];
+        out[i + 3] = lut[index[3]];
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = lut[int(qMin(intensity[i] * scale, last))];
+}
+
+namespace {
+
+// Collects the pixels of consecutive line steps and writes every run of
+// adjacent pixels within one column as a single vertical span.
+class SpanWriter
+{
+public:
+    SpanWriter(quint32 *bits, int stride, quint32 color)
+        : m_bits(bits), m_stride(stride), m_color(color), m_x(-1), m_low(0), m_high(0) {}
+
+    void plot(int x, int y)
+    {
+        // a gap in the column starts a new span, so it is not filled in
+        if (x == m_x && y >= m_low - 1 && y <= m_high + 1) {
+            m_low = qMin(m_low, y);
+            m_high = qMax(m_high, y);
+        } else {
+            flush();
+            m_x = x;
+            m_low = m_high = y;
+        }
+    }
+
+    void flush()
+    {
+        if (m_x < 0)
+            return;
+
+        quint32 *p = m_bits + m_low * m_stride + m_x;
+        for (int y = m_low; y <= m_high; ++y, p += m_stride)
+            *p = m_color;
+    }
+
+private:
+    quint32 *m_bits;
+    int m_stride;
+    quint32 m_color;
+    int m_x;
+    int m_low;
+    int m_high;
+};
+
+// Liang-Barsky clipping of the line (x0, y0) - (x1, y1) to the rectangle
+// from (0, 0) to (right, bottom), returns false if nothing is left
+bool clipLine(qreal &x0, qreal &y0, qreal &x1, qreal &y1, qreal right, qreal bottom)
+{
+    const qreal dx = x1 - x0;
+    const qreal dy = y1 - y0;
+    const qreal p[4] = { -dx, dx, -dy, dy };
+    const qreal q[4] = { x0, right - x0, y0, bottom - y0 };
+
+    qreal t0 = 0;
+    qreal t1 = 1;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0) {
+            if (q[i] < 0)
+                return false;
+            continue;
+        }
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0)
+            t0 = qMax(t0, t);
+        else
+            t1 = qMin(t1, t);
+        if (t0 > t1)
+            return false;
+    }
+
+    x1 = x0 + t1 * dx;
+    y1 = y0 + t1 * dy;
+    x0 = x0 + t0 * dx;
+    y0 = y0 + t0 * dy;
+    return true;
+}
+
+} // namespace
+
+void qtBasicGraphRasterizePolyline(quint32 *bits, int stride, int width, int height,
+                                   const QPointF *points, int count, qreal dx, qreal dy, quint32 color)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    SpanWriter writer(bits, stride, color);
+    const qreal right = width - 1;
+    const qreal bottom = height - 1;
+
+    for (int i = 1; i < count; ++i) {
+        qreal fx0 = points[i - 1].x() + dx;
+        qreal fy0 = points[i - 1].y() + dy;
+        qreal fx1 = points[i].x() + dx;
+        qreal fy1 = points[i].y() + dy;
+
+        if (!clipLine(fx0, fy0, fx1, fy1, right, bottom))
+            continue;
+
+        int x0 = qBound(0, int(fx0 + qreal(0.5)), width - 1);
+        int y0 = qBound(0, int(fy0 + qreal(0.5)), height - 1);
+        const int x1 = qBound(0, int(fx1 + qreal(0.5)), width - 1);
+        const int y1 = qBound(0, int(fy1 + qreal(0.5)), height - 1);
+
+        // Bresenham
+        const int ax = qAbs(x1 - x0);
+        const int ay = -qAbs(y1 - y0);
+        const int sx = x0 < x1 ? 1 : -1;
+        const int sy = y0 < y1 ? 1 : -1;
+        int error = ax + ay;
+
+        forever {
+            writer.plot(x0, y0);
+            if (x0 == x1 && y0 == y1)
+                break;
+            const int e2 = 2 * error;
+            if (e2 >= ay) {
+                error += ay;
+                x0 += sx;
+            }
+            if (e2 <= ax) {
+                error += ax;
+                y0 += sy;
+            }
+        }
+    }
+
+    writer.flush();
+}
+
+void qtBasicGraphAccumulateHits(float *hits, int width, int height,
+                                const QPointF *points, int count, qreal dx, qreal dy)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    const qreal right = width - 1;
+    const qreal bottom = height - 1;
+
+    if (count == 1) {
+        const int x = int(points[0].x() + dx + qreal(0.5));
+        const int y = int(points[0].y() + dy + qreal(0.5));
+        if (x >= 0 && x < width && y >= 0 && y < height)
+            hits[y * width + x] += 1;
+        return;
+    }
+
+    for (int i = 1; i < count; ++i) {
+        const qreal sx0 = points[i - 1].x() + dx;
+        const qreal sy0 = points[i - 1].y() + dy;
+        qreal fx0 = sx0;
+        qreal fy0 = sy0;
+        qreal fx1 = points[i].x() + dx;
+        qreal fy1 = points[i].y() + dy;
+
+        if (!clipLine(fx0, fy0, fx1, fy1, right, bottom))
+            continue;
+
+        // the start of a segment was already hit as the end of the one before
+        bool skip = i > 1 && fx0 == sx0 && fy0 == sy0;
+
+        int x0 = qBound(0, int(fx0 + qreal(0.5)), width - 1);
+        int y0 = qBound(0, int(fy0 + qreal(0.5)), height - 1);
+        const int x1 = qBound(0, int(fx1 + qreal(0.5)), width - 1);
+        const int y1 = qBound(0, int(fy1 + qreal(0.5)), height - 1);
+
+        // Bresenham
+        const int ax = qAbs(x1 - x0);
+        const int ay = -qAbs(y1 - y0);
+        const int sx = x0 < x1 ? 1 : -1;
+        const int sy = y0 < y1 ? 1 : -1;
+        int error = ax + ay;
+
+        forever {
+            if (!skip)
+                hits[y0 * width + x0] += 1;
+            skip = false;
+            if (x0 == x1 && y0 == y1)
+                break;
+            const int e2 = 2 * error;
+            if (e2 >= ay) {
+                error += ay;
+                x0 += sx;
+            }
+            if (e2 <= ax) {
+                error += ax;
+                y0 += sy;
+            }
+        }
+    }
+}
+
+int qtBasicGraphStepPolyline(const QPointF *points, int count, QPointF *out)
+{
+    if (count <= 0)
+        return 0;
+
+    for (int i = 0; i < count - 1; ++i) {
+        out[2 * i] = points[i];
+        out[2 * i + 1] = QPointF(points[i + 1].x(), points[i].y());
+    }
+    out[2 * count - 2] = points[count - 1];
+    return 2 * count - 1;
+}
+
+void qtBasicGraphColumnEnvelope(const QPointF *points, int count, qreal dx, qreal dy,
+                                int columns, float *top, float *bottom)
+{
+    std::fill(top, top + columns, std::numeric_limits<float>::max());
+    std::fill(bottom, bottom + columns, -std::numeric_limits<float>::max());
+
+    // a single point is a line to itself
+    for (int i = 0; i < qMax(count - 1, qMin(count, 1)); ++i) {
+        const QPointF &a = points[i];
+        const QPointF &b = points[qMin(i + 1, count - 1)];
+        qreal x0 = a.x() + dx;
+        qreal y0 = a.y() + dy;
+        qreal x1 = b.x() + dx;
+        qreal y1 = b.y() + dy;
+        if (x1 < x0) {
+            qSwap(x0, x1);
+            qSwap(y0, y1);
+        }
+
+        if (!(x1 >= 0 && x0 < columns))
+            continue;
+
+        // clipped to the columns first, so the conversions cannot overflow
+        const int c0 = qFloor(qMax(x0, qreal(0)));
+        const int c1 = qMin(columns - 1, qFloor(qMin(x1, qreal(columns))));
+        const qreal slope = x1 > x0 ? (y1 - y0) / (x1 - x0) : qreal(0);
+
+        for (int c = c0; c <= c1; ++c) {
+            qreal ya = y0;
+            qreal yb = y1;
+            if (x1 > x0) {
+                ya = y0 + (qMax(x0, qreal(c)) - x0) * slope;
+                yb = y0 + (qMin(x1, qreal(c + 1)) - x0) * slope;
+            }
+            top[c] = qMin(top[c], float(qMin(ya, yb)));
+            bottom[c] = qMax(bottom[c], float(qMax(ya, yb)));
+        }
+    }
+}
+
+namespace {
+
+// x * a / 255 for all four 8 bit channels of x
+inline quint32 byteMul(quint32 x, uint a)
+{
+    quint32 t = (x & 0xff00ff) * a;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = x + ((x >> 8) & 0xff00ff) + 0x800080;
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+// premultiplied source over
+inline quint32 blend(quint32 dst, quint32 src)
+{
+    return src + byteMul(dst, 255 - (src >> 24));
+}
+
+} // namespace
+
+void qtBasicGraphFillColumns(quint32 *bits, int stride, int width, int height,
+                             const float *top, const float *bottom, float base, quint32 color)
+{
+    const uint alpha = color >> 24;
+    if (alpha == 0 || height <= 0)
+        return;
+
+    for (int x = 0; x < width; ++x) {
+        if (top[x] > bottom[x])
+            continue;
+
+        // clamped before the conversion, the envelope of samples far
+        // outside the y range may not fit into an int; rounded down, so a
+        // span above the image ends at row -1 instead of 0
+        const float low = qBound(-1.0f, qMin(top[x], base), float(height));
+        const float high = qBound(-1.0f, qMax(bottom[x], base), float(height));
+        const int y0 = qMax(0, qFloor(low + 0.5f));
+        const int y1 = qMin(height - 1, qFloor(high + 0.5f));
+
+        quint32 *p = bits + y0 * stride + x;
+        if (alpha == 255) {
+            for (int y = y0; y <= y1; ++y, p += stride)
+                *p = color;
+        } else {
+            for (int y = y0; y <= y1; ++y, p += stride)
+                *p = blend(*p, color);
+        }
+    }
+}
+
+void qtBasicGraphBlitSprite(quint32 *bits, int stride, int width, int height,
+                            const quint32 *sprite, int size,
+                            const QPointF *points, int count, qreal dx, qreal dy)
+{
+    const qreal offset = qreal(0.5) - size / qreal(2);
+    int lastx = std::numeric_limits<int>::min();
+    int lasty = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const qreal fx = points[i].x() + dx + offset;
+        const qreal fy = points[i].y() + dy + offset;
+
+        // sprites outside of the image are skipped before the conversion,
+        // which could overflow for points far outside
+        if (!(fx > -size && fx < width && fy > -size && fy < height))
+            continue;
+
+        const int x0 = qFloor(fx);
+        const int y0 = qFloor(fy);
+        if (x0 == lastx && y0 == lasty)
+            continue;
+        lastx = x0;
+        lasty = y0;
+
+        const int left = qMax(0, -x0);
+        const int right = qMin(size, width - x0);
+        const int top = qMax(0, -y0);
+        const int bottom = qMin(size, height - y0);
+
+        for (int sy = top; sy < bottom; ++sy) {
+            const quint32 *src = sprite + sy * size;
+            quint32 *dst = bits + (y0 + sy) * stride + x0;
+            for (int sx = left; sx < right; ++sx) {
+                if (src[sx])
+                    dst[sx] = blend(dst[sx], src[sx]);
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Vectorized sample kernels used by QtBasicGraph for painting.
+#ifndef QT_BASIC_GRAPH_KERNELS_H
+#define QT_BASIC_GRAPH_KERNELS_H
+
+#include <QtCore/QPointF>
+
+// orders points by their x value, for the binary searches of an x value
+// with std::lower_bound() and std::upper_bound()
+struct QtBasicGraphLessX
+{
+    bool operator()(const QPointF &point, qreal x) const { return point.x() < x; }
+    bool operator()(qreal x, const QPointF &point) const { return x < point.x(); }
+};
+
+// out[i] = ((points[i].x - x0) * sx, (points[i].y - y0) * sy)
+void qtBasicGraphMapPoints(const QPointF *points, int count,
+                           qreal x0, qreal y0, qreal sx, qreal sy, QPointF *out);
+
+// out[i] = (x + i * dx, (y[i] - y0) * sy)
+void qtBasicGraphMapSamples(const float *y, int count,
+                            qreal x, qreal dx, qreal y0, qreal sy, QPointF *out);
+
+// out[i] = ((x[i] - x0) * sx, (y[i] - y0) * sy)
+void qtBasicGraphMapSamples(const qreal *x, const float *y, int count,
+                            qreal x0, qreal y0, qreal sx, qreal sy, QPointF *out);
+
+// minimum and maximum of count values, count has to be at least 1
+void qtBasicGraphMinMax(const float *y, int count, float *min, float *max);
+void qtBasicGraphMinMax(const QPointF *points, int count, qreal *min, qreal *max);
+
+// index i of the first sample that crosses level coming from the sample
+// before it, y[i - 1] < level <= y[i] for a rising and y[i - 1] > level >= y[i]
+// for a falling edge, -1 if there is no crossing
+int qtBasicGraphFindCrossing(const float *y, int count, float level, bool rising);
+int qtBasicGraphFindCrossing(const QPointF *points, int count, qreal level, bool rising);
+
+// intensity[i] = intensity[i] * decay + hits[i]
+void qtBasicGraphAccumulate(float *intensity, const float *hits, int count, float decay);
+
+// intensity[i] = intensity[i] * decay
+void qtBasicGraphDecay(float *intensity, int count, float decay);
+
+// out[i] = lut[min(int(intensity[i] * scale), size - 1)], intensities are
+// not negative
+void qtBasicGraphMapIntensity(const float *intensity, int count, float scale,
+                              const quint32 *lut, int size, quint32 *out);
+
+// draws a 1 pixel wide, not antialiased polyline into a 32 bit image with
+// stride pixels per line, the points are translated by (dx, dy) first
+void qtBasicGraphRasterizePolyline(quint32 *bits, int stride, int width, int height,
+                                   const QPointF *points, int count, qreal dx, qreal dy, quint32 color);
+
+// adds one hit to every pixel of the polyline in a width x height buffer,
+// pixels shared by two consecutive lines are only hit once
+void qtBasicGraphAccumulateHits(float *hits, int width, int height,
+                                const QPointF *points, int count, qreal dx, qreal dy);
+
+// writes the step polyline of count points to out, which needs room for
+// 2 * count - 1 points: every point is followed by a horizontal line to
+// the x value of the next one, returns the number of points written
+int qtBasicGraphStepPolyline(const QPointF *points, int count, QPointF *out);
+
+// top[c] and bottom[c] are set to the smallest and largest y value of the
+// polyline within the pixel column c, c < columns, after translating it by
+// (dx, dy); columns it does not touch get top[c] > bottom[c]
+void qtBasicGraphColumnEnvelope(const QPointF *points, int count, qreal dx, qreal dy,
+                                int columns, float *top, float *bottom);
+
+// blends the premultiplied color over the span from min(top[x], base) to
+// max(bottom[x], base) of every column x that has a valid envelope
+void qtBasicGraphFillColumns(quint32 *bits, int stride, int width, int height,
+                             const float *top, const float *bottom, float base, quint32 color);
+
+// blends the premultiplied size x size sprite over a 32 bit image, centered
+// on every point translated by (dx, dy); points that fall on the same pixel
+// as the one before are skipped
+void qtBasicGraphBlitSprite(quint32 *bits, int stride, int width, int height,
+                            const quint32 *sprite, int size,
+                            const QPointF *points, int count, qreal dx, qreal dy);
+
+#endif // QT_BASIC_GRAPH_KERNELS_H
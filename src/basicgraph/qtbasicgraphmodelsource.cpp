@@ -0,0 +1,184 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraphmodelsource.h"
+
+#include <QtCore/QAbstractItemModel>
+
+#include <algorithm>
+
+/*!
+
+    \class QtBasicGraphModelSource qtbasicgraphmodelsource.h
+
+    \brief The QtBasicGraphModelSource class reads the data of a QtBasicGraph
+    from the rows of a QAbstractItemModel.
+
+    Every row of the model is one sample. The x value is read from the
+    xColumn(), every column in yColumns() is shown as a trace of its own.
+    The x values have to be in ascending order.
+
+    The values are read once and kept in arrays, the x values once for all
+    traces and the y values of every trace as floats. Inserted, removed and
+    changed rows only read or drop the affected rows and are reported with
+    pointsInserted(), pointsRemoved() and pointsChanged(), so the attached
+    graphs only repaint the part of the view that changed. Only a reset or
+    a layout change of the model reads all rows again.
+
+    Rows removed from the front, like the oldest rows of a model that
+    appends new rows and removes old ones, are not moved out of the
+    arrays; the arrays are compacted once more than half of them is
+    unused, so streaming rows through the source costs amortized O(1) per
+    row. pointsAboutToBeRemoved() is emitted while the removed rows can
+    still be read.
+
+    A source can be shared by any number of graphs, for example an overview
+    and a detail view, see QtBasicGraph::setModelSource(). The samples are
+    then held only once.
+
+*/
+
+/*!
+    Creates a source for the rows of \a model with the x values in column
+    \a xColumn and the traces in \a yColumns.
+*/
+QtBasicGraphModelSource::QtBasicGraphModelSource(QAbstractItemModel *model, int xColumn,
+                                                 const QList<int> &yColumns, QObject *parent)
+    : QObject(parent), m_model(model), m_x_column(xColumn), m_y_columns(yColumns), m_head(0)
+{
+    m_series.resize(m_y_columns.size());
+
+    if (m_model) {
+        connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(insertRows(QModelIndex,int,int)));
+        connect(m_model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(removeRows(QModelIndex,int,int)));
+        connect(m_model, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(changeRows(QModelIndex,QModelIndex)));
+        connect(m_model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(reload()));
+        connect(m_model, SIGNAL(layoutChanged()), this, SLOT(reload()));
+        connect(m_model, SIGNAL(modelReset()), this, SLOT(reload()));
+        connect(m_model, SIGNAL(destroyed()), this, SLOT(reload()));
+    }
+
+    reload();
+}
+
+/*!
+    Destructor
+*/
+QtBasicGraphModelSource::~QtBasicGraphModelSource()
+{
+}
+
+qreal QtBasicGraphModelSource::firstX() const
+{
+    return count() == 0 ? qreal(0) : m_x.at(m_head);
+}
+
+qreal QtBasicGraphModelSource::lastX() const
+{
+    return count() == 0 ? qreal(0) : m_x.last();
+}
+
+/*!
+    Returns the index of the first sample with an x value not less than \a x,
+    or count() if there is no such sample.
+*/
+int QtBasicGraphModelSource::lowerBound(qreal x) const
+{
+    return std::lower_bound(m_x.constBegin() + m_head, m_x.constEnd(), x) - m_x.constBegin() - m_head;
+}
+
+void QtBasicGraphModelSource::insertRows(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int n = last - first + 1;
+    m_x.insert(m_head + first, n, 0);
+    for (int s = 0; s < m_series.size(); ++s)
+        m_series[s].insert(m_head + first, n, 0);
+
+    readRows(first, n);
+    emit pointsInserted(first, n);
+}
+
+void QtBasicGraphModelSource::removeRows(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int n = last - first + 1;
+    emit pointsAboutToBeRemoved(first, n);
+
+    if (first > 0) {
+        m_x.remove(m_head + first, n);
+        for (int s = 0; s < m_series.size(); ++s)
+            m_series[s].remove(m_head + first, n);
+    } else {
+        m_head += n;
+
+        // compact lazily, so removing the oldest rows stays amortized O(1)
+        if (m_head > m_x.size() / 2) {
+            m_x.remove(0, m_head);
+            for (int s = 0; s < m_series.size(); ++s)
+                m_series[s].remove(0, m_head);
+            m_head = 0;
+        }
+    }
+
+    emit pointsRemoved(first, n);
+}
+
+void QtBasicGraphModelSource::changeRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (topLeft.parent().isValid())
+        return;
+
+    // ignore changes of columns that are not shown
+    bool shown = m_x_column >= topLeft.column() && m_x_column <= bottomRight.column();
+    foreach (int column, m_y_columns)
+        shown = shown || (column >= topLeft.column() && column <= bottomRight.column());
+    if (!shown)
+        return;
+
+    const int n = bottomRight.row() - topLeft.row() + 1;
+    readRows(topLeft.row(), n);
+    emit pointsChanged(topLeft.row(), n);
+}
+
+/*!
+    \internal
+    Reads all rows of the model again.
+*/
+void QtBasicGraphModelSource::reload()
+{
+    const int rows = m_model ? m_model->rowCount() : 0;
+    m_head = 0;
+    m_x.resize(rows);
+    for (int s = 0; s < m_series.size(); ++s)
+        m_series[s].resize(rows);
+
+    readRows(0, rows);
+    emit pointsReset();
+}
+
+/*!
+    \internal
+    Reads \a count rows starting at row \a first into the already allocated
+    values with the same indexes.
+*/
+void QtBasicGraphModelSource::readRows(int first, int count)
+{
+    if (!m_model)
+        return;
+
+    for (int row = first; row < first + count; ++row) {
+        m_x[m_head + row] = m_model->index(row, m_x_column).data().toDouble();
+        for (int s = 0; s < m_series.size(); ++s)
+            m_series[s][m_head + row] = m_model->index(row, m_y_columns.at(s)).data().toFloat();
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Item model adapter that feeds one or more QtBasicGraph views.
+#ifndef QT_BASIC_GRAPH_MODEL_SOURCE_H
+#define QT_BASIC_GRAPH_MODEL_SOURCE_H
+
+#include <QtCore/QObject>
+#include <QtCore/QList>
+#include <QtCore/QPointF>
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+
+class QtBasicGraphModelSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    QtBasicGraphModelSource(QAbstractItemModel *model, int xColumn, const QList<int> &yColumns,
+                            QObject *parent = 0);
+    ~QtBasicGraphModelSource();
+
+    QAbstractItemModel *model() const { return m_model; }
+    int xColumn() const               { return m_x_column; }
+    QList<int> yColumns() const       { return m_y_columns; }
+
+    int seriesCount() const { return m_series.size(); }
+    int count() const       { return m_x.size() - m_head; }
+    const qreal *x() const  { return m_x.constData() + m_head; }
+    const float *y(int series) const { return m_series.at(series).constData() + m_head; }
+    QPointF point(int series, int index) const
+    { return QPointF(m_x.at(m_head + index), m_series.at(series).at(m_head + index)); }
+
+    qreal firstX() const;
+    qreal lastX() const;
+    int lowerBound(qreal x) const;
+
+Q_SIGNALS:
+    void pointsInserted(int first, int count);
+    void pointsAboutToBeRemoved(int first, int count);
+    void pointsRemoved(int first, int count);
+    void pointsChanged(int first, int count);
+    void pointsReset();
+
+private Q_SLOTS:
+    void insertRows(const QModelIndex &parent, int first, int last);
+    void removeRows(const QModelIndex &parent, int first, int last);
+    void changeRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void reload();
+
+private:
+    friend class QtBasicGraph;   // snapshots the arrays for threaded rendering
+
+    void readRows(int first, int count);
+
+    QPointer<QAbstractItemModel> m_model;
+    int m_x_column;
+    QList<int> m_y_columns;
+
+    // the x values are stored once, every y column only stores its values;
+    // the rows start at m_head, rows removed from the front only advance it
+    QVector<qreal> m_x;
+    QVector<QVector<float> > m_series;
+    int m_head;
+};
+
+#endif // QT_BASIC_GRAPH_MODEL_SOURCE_H
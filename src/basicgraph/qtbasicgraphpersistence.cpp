@@ -0,0 +1,183 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+#include "qtbasicgraphkernels.h"
+
+#include <algorithm>
+
+/*!
+    \internal
+    Returns true if the trace layer shows the density image.
+*/
+bool QtBasicGraph::usePersistence() const
+{
+    return m_persistence && !m_source && !usesHistory() && devicePixelRatioF() == 1;
+}
+
+/*!
+    \internal
+    Renders a frame of the density image. The intensity of the whole layer
+    is multiplied with persistenceDecay(), so older data fades out in the
+    free running and in the triggered mode alike. The hits of the samples in
+    \a rect are then added to the intensity if \a accumulate is true, or
+    replace it.
+
+    The decay only multiplies the common scale of all pixels, the stored
+    intensities are scaled once it gets too small to add hits precisely.
+    Only \a rect and the band scheduled by schedulePersistenceBand() are
+    mapped to colors, the rest of the layer keeps its colors until its band
+    comes up.
+*/
+void QtBasicGraph::renderPersistence(const QRect &rect, bool accumulate)
+{
+    const int width = m_trace_layer.width();
+    const int height = m_trace_layer.height();
+
+    if (m_intensity.size() != width * height) {
+        m_intensity.fill(0, width * height);
+        m_persistence_scale = 1;
+    }
+
+    if (m_persistence_lut.isEmpty()) {
+        const QColor middle = palette().color(QPalette::Highlight);
+        const QColor end = palette().color(QPalette::Text);
+        m_persistence_lut.resize(256);
+        for (int i = 0; i < 256; ++i) {
+            // fade in the highlight color, then blend it into the text color
+            const qreal t = qMax(0, i - 128) / qreal(127);
+            const QRgb color = qRgba(int(middle.red() + t * (end.red() - middle.red())),
+                                     int(middle.green() + t * (end.green() - middle.green())),
+                                     int(middle.blue() + t * (end.blue() - middle.blue())),
+                                     qMin(2 * i, 255));
+            m_persistence_lut[i] = qPremultiply(color);
+        }
+    }
+
+    // the samples of the live window or the copied capture
+    const QPointF *data = isFixedRate() ? 0 : values();
+    int count = sampleCount();
+    if (showsCapture() && !m_capture.isEmpty()) {
+        data = m_capture.constData();
+        count = m_capture.size();
+    }
+    traceLive(rect, data, count, &m_trace);
+
+    m_hits.fill(0, rect.width() * rect.height());
+    qtBasicGraphAccumulateHits(m_hits.data(), rect.width(), rect.height(), m_trace.constData(), m_trace.size(),
+                               -rect.x(), -rect.y());
+
+    // below this scale the hits added to the stored intensities lose precision
+    const qreal minScale = 1e-6;
+    qreal scale = m_persistence_scale * m_persistence_decay;
+    if (scale < minScale) {
+        qtBasicGraphDecay(m_intensity.data(), m_intensity.size(), float(scale));
+        scale = 1;
+    }
+    m_persistence_scale = scale;
+
+    // the hits are stored relative to the scale of the intensity
+    qtBasicGraphDecay(m_hits.data(), m_hits.size(), float(1 / scale));
+
+    const float lutScale = float((m_persistence_lut.size() - 1) / m_persistence_saturation * scale);
+    const int stride = m_trace_layer.bytesPerLine() / 4;
+    quint32 *bits = reinterpret_cast<quint32 *>(m_trace_layer.bits());
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        float *intensity = m_intensity.data() + y * width + rect.left();
+        const float *hits = m_hits.constData() + (y - rect.y()) * rect.width();
+        if (accumulate)
+            qtBasicGraphAccumulate(intensity, hits, rect.width(), 1);
+        else
+            std::copy(hits, hits + rect.width(), intensity);
+        qtBasicGraphMapIntensity(intensity, rect.width(), lutScale, m_persistence_lut.constData(),
+                                 m_persistence_lut.size(), bits + y * stride + rect.left());
+    }
+
+    const QRect band = m_persistence_band & QRect(0, 0, width, height);
+    m_persistence_band = QRect();
+    for (int y = band.top(); y <= band.bottom(); ++y) {
+        qtBasicGraphMapIntensity(m_intensity.constData() + y * width + band.left(), band.width(), lutScale,
+                                 m_persistence_lut.constData(), m_persistence_lut.size(),
+                                 bits + y * stride + band.left());
+    }
+}
+
+/*!
+    \internal
+    Schedules the next band of PersistenceBands bands of columns for the
+    next frame of the density image, so all of its colors follow the decay
+    within that many frames while every frame only maps and repaints the
+    scrolled in columns and one band.
+*/
+void QtBasicGraph::schedulePersistenceBand()
+{
+    const int band = (width() + PersistenceBands - 1) / PersistenceBands;
+    if (m_persistence_next_band >= width())
+        m_persistence_next_band = 0;
+
+    const QRect rect(m_persistence_next_band, 0, band, height());
+    m_persistence_band |= rect & this->rect();
+    m_persistence_next_band += band;
+    update(rect);
+}
+
+/*!
+    Enables or disables the persistence mode, which shows the live data or
+    the triggered captures as a density image. The history and model
+    sources are still drawn as a line.
+*/
+void QtBasicGraph::setPersistence(bool enabled)
+{
+    m_persistence = enabled;
+    if (!enabled) {
+        m_intensity.clear();
+        m_hits.clear();
+        m_persistence_band = QRect();
+    }
+    m_scroll_error = 0;
+    invalidate();
+}
+
+/*!
+    Sets the factor the intensity of every pixel is multiplied with in every
+    rendered frame, before the new data is added. In the triggered mode 0
+    shows only the latest capture, while the view scrolls the older data
+    fades out behind the newest samples. Values close to 1 keep older data
+    visible for longer. The default is 0.8.
+*/
+void QtBasicGraph::setPersistenceDecay(qreal decay)
+{
+    m_persistence_decay = qBound(qreal(0), decay, qreal(1));
+}
+
+/*!
+    Sets the number of \a hits a pixel needs for the last color of the
+    color table. The default is 16.
+*/
+void QtBasicGraph::setPersistenceSaturation(qreal hits)
+{
+    m_persistence_saturation = qMax(hits, qreal(1));
+    invalidate();
+}
+
+/*!
+    Sets the color table of the persistence mode. The first color is used
+    for pixels without hits and the last for pixels with at least
+    persistenceSaturation() hits. By default the table fades from
+    transparent through the highlight color to the text color of the
+    palette; an empty \a colors restores the default.
+*/
+void QtBasicGraph::setPersistenceColors(const QVector<QRgb> &colors)
+{
+    m_persistence_custom_colors = !colors.isEmpty();
+    m_persistence_lut.resize(colors.size());
+    for (int i = 0; i < colors.size(); ++i)
+        m_persistence_lut[i] = qPremultiply(colors.at(i));
+    invalidate();
+}
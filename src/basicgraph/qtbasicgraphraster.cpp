@@ -0,0 +1,445 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+#include "qtbasicgraphhistory.h"
+#include "qtbasicgraphkernels.h"
+
+#include <algorithm>
+#include <limits>
+
+/*!
+    \internal
+    Returns true if the trace is drawn by qtBasicGraphRasterizePolyline()
+    instead of QPainter.
+*/
+bool QtBasicGraph::useFastRaster() const
+{
+    return m_fast_raster && !(m_render_hints & QPainter::Antialiasing) && devicePixelRatioF() == 1;
+}
+
+/*!
+    \internal
+    Clears the part \a rect of the trace layer and traces it again.
+*/
+void QtBasicGraph::renderTrace(const QRect &rect)
+{
+    if (useFastRaster()) {
+        // opaque ARGB32 premultiplied pixels have the same layout as RGB32,
+        // so the rasterizer can write into the part of the layer directly
+        const int stride = m_trace_layer.bytesPerLine() / 4;
+        quint32 *bits = reinterpret_cast<quint32 *>(m_trace_layer.bits()) + rect.y() * stride + rect.x();
+
+        for (int y = 0; y < rect.height(); ++y)
+            std::fill(bits + y * stride, bits + y * stride + rect.width(), 0u);
+
+        for (int i = 0; i < traceCount(); ++i) {
+            trace(i, rect, &m_trace);
+            rasterizeTrace(bits, stride, rect.width(), rect.height(), traceStyle(i), m_trace,
+                           -rect.x(), -rect.y(), &m_style_buffer);
+        }
+        return;
+    }
+
+    QPainter p(&m_trace_layer);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.fillRect(rect, Qt::transparent);
+    p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    p.setClipRect(rect);
+
+    if (m_render_hints)
+        p.setRenderHints(m_render_hints);
+
+    for (int i = 0; i < traceCount(); ++i) {
+        trace(i, rect, &m_trace);
+        paintTrace(&p, rect, traceStyle(i), m_trace, &m_style_buffer);
+    }
+}
+
+/*!
+    \internal
+    Returns the number of traces, one for every y column of a model source.
+*/
+int QtBasicGraph::traceCount() const
+{
+    return m_source ? m_source->seriesCount() : 1;
+}
+
+/*!
+    \internal
+    Returns the color of the trace \a index. The first trace is drawn in the
+    text color of the palette, the others in evenly spread hues.
+*/
+QColor QtBasicGraph::traceColor(int index) const
+{
+    if (index == 0)
+        return palette().color(QPalette::Text);
+    return QColor::fromHsv((210 + 110 * (index - 1)) % 360, 200, 220);
+}
+
+/*!
+    \internal
+    Returns the style of the trace \a index. The marker sprite is taken
+    from the cache filled by updateSprites().
+*/
+QtBasicGraph::TraceStyle QtBasicGraph::traceStyle(int index) const
+{
+    TraceStyle style;
+    style.style = m_render_style;
+    style.color = traceColor(index);
+    style.base = (m_ymax - qBound(m_ymin, qreal(0), m_ymax)) * height() / (m_ymax - m_ymin);
+    if (m_render_style == Scatter)
+        style.sprite = m_sprites.value(style.color.rgba());
+    return style;
+}
+
+/*!
+    \internal
+    Creates the antialiased scatter markers in the colors of all traces for
+    the device pixel ratio of the widget. Called when the style or the
+    palette changes and before painting, which only has to create the
+    sprites of new traces or after the widget moved to a screen with
+    another pixel ratio.
+*/
+void QtBasicGraph::updateSprites()
+{
+    if (m_render_style != Scatter) {
+        m_sprites.clear();
+        return;
+    }
+
+    const qreal dpr = devicePixelRatioF();
+    if (dpr != m_sprite_dpr) {
+        m_sprites.clear();
+        m_sprite_dpr = dpr;
+    }
+
+    for (int i = 0; i < traceCount(); ++i) {
+        const QColor color = traceColor(i);
+        QImage &sprite = m_sprites[color.rgba()];
+        if (!sprite.isNull())
+            continue;
+
+        const int size = qCeil(MarkerSize * dpr);
+        sprite = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+        sprite.fill(0);
+        sprite.setDevicePixelRatio(dpr);
+
+        QPainter p(&sprite);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setPen(Qt::NoPen);
+        p.setBrush(color);
+        p.drawEllipse(QRectF(0, 0, size / dpr, size / dpr));
+    }
+}
+
+/*!
+    \internal
+    Draws the traced \a points with \a painter in the given \a style, the
+    part \a rect of the view is painted. \a buffer holds the step polyline.
+    The function only depends on its arguments, so it can run on the render
+    thread.
+*/
+void QtBasicGraph::paintTrace(QPainter *painter, const QRect &rect, const TraceStyle &style,
+                              const QVector<QPointF> &points, QVector<QPointF> *buffer)
+{
+    const int count = points.size();
+    if (count == 0)
+        return;
+
+    switch (style.style) {
+    case Steps:
+        buffer->resize(2 * count - 1);
+        qtBasicGraphStepPolyline(points.constData(), count, buffer->data());
+        painter->setPen(style.color);
+        painter->drawPolyline(buffer->constData(), buffer->size());
+        break;
+
+    case Scatter: {
+        const qreal half = style.sprite.width() / style.sprite.devicePixelRatioF() / 2;
+        QPoint last(std::numeric_limits<int>::min(), 0);
+        for (int i = 0; i < count; ++i) {
+            const QPointF &point = points.at(i);
+            const QPoint pos(qFloor(point.x() + qreal(0.5) - half), qFloor(point.y() + qreal(0.5) - half));
+            if (pos != last)
+                painter->drawImage(pos, style.sprite);
+            last = pos;
+        }
+        break;
+    }
+
+    case FilledArea: {
+        // one rectangle from the zero line to the far end of the trace per
+        // pixel column, neighbours with the same span are merged
+        const int left = rect.left() - 1;
+        const int columns = rect.width() + 2;
+        QVarLengthArray<float, 1024> top(columns);
+        QVarLengthArray<float, 1024> bottom(columns);
+        qtBasicGraphColumnEnvelope(points.constData(), count, -left, 0, columns, top.data(), bottom.data());
+
+        QVarLengthArray<QRect, 256> rects;
+        for (int c = 0; c < columns; ++c) {
+            if (top[c] > bottom[c])
+                continue;
+            const int y0 = qRound(qMin(qreal(top[c]), style.base));
+            const int y1 = qRound(qMax(qreal(bottom[c]), style.base));
+            if (!rects.isEmpty() && rects.last().right() == left + c - 1
+                && rects.last().top() == y0 && rects.last().bottom() == y1)
+                rects.last().setRight(left + c);
+            else
+                rects.append(QRect(left + c, y0, 1, y1 - y0 + 1));
+        }
+
+        QColor fill = style.color;
+        fill.setAlphaF(fill.alphaF() * 0.35);
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(fill);
+        painter->drawRects(rects.constData(), rects.size());
+        painter->restore();
+
+        painter->setPen(style.color);
+        painter->drawPolyline(points.constData(), count);
+        break;
+    }
+
+    default:
+        painter->setPen(style.color);
+        painter->drawPolyline(points.constData(), count);
+        break;
+    }
+}
+
+/*!
+    \internal
+    Draws the traced \a points translated by (\a dx, \a dy) in the given
+    \a style into a 32 bit image, see qtBasicGraphRasterizePolyline().
+*/
+void QtBasicGraph::rasterizeTrace(quint32 *bits, int stride, int width, int height, const TraceStyle &style,
+                                  const QVector<QPointF> &points, qreal dx, qreal dy, QVector<QPointF> *buffer)
+{
+    const int count = points.size();
+    if (count == 0 || width <= 0 || height <= 0)
+        return;
+
+    const quint32 color = style.color.rgb();
+
+    switch (style.style) {
+    case Steps:
+        buffer->resize(2 * count - 1);
+        qtBasicGraphStepPolyline(points.constData(), count, buffer->data());
+        qtBasicGraphRasterizePolyline(bits, stride, width, height, buffer->constData(), buffer->size(), dx, dy, color);
+        break;
+
+    case Scatter:
+        qtBasicGraphBlitSprite(bits, stride, width, height, reinterpret_cast<const quint32 *>(style.sprite.constBits()),
+                               style.sprite.width(), points.constData(), count, dx, dy);
+        break;
+
+    case FilledArea: {
+        QVarLengthArray<float, 1024> top(width);
+        QVarLengthArray<float, 1024> bottom(width);
+        qtBasicGraphColumnEnvelope(points.constData(), count, dx, dy, width, top.data(), bottom.data());
+
+        QColor fill = style.color;
+        fill.setAlphaF(fill.alphaF() * 0.35);
+        qtBasicGraphFillColumns(bits, stride, width, height, top.constData(), bottom.constData(),
+                                float(style.base + dy), qPremultiply(fill.rgba()));
+        qtBasicGraphRasterizePolyline(bits, stride, width, height, points.constData(), count, dx, dy, color);
+        break;
+    }
+
+    default:
+        qtBasicGraphRasterizePolyline(bits, stride, width, height, points.constData(), count, dx, dy, color);
+        break;
+    }
+}
+
+/*!
+    \internal
+    Stores the trace \a index through the part \a rect of the view in device
+    coordinates in \a points, ready to be drawn as a single polyline.
+*/
+void QtBasicGraph::trace(int index, const QRect &rect, QVector<QPointF> *points) const
+{
+    points->resize(0);
+
+    if (m_source) {
+        const TraceData samples = { 0, m_source->x(), m_source->y(index), m_source->count(), 0, 0 };
+        traceSamples(traceView(), rect, samples, points);
+    } else if (showsCapture() && !m_capture.isEmpty())
+        traceLive(rect, m_capture.constData(), m_capture.size(), points);
+    else if (usesHistory())
+        traceHistory(rect, points);
+    else if (sampleCount() >= 2)
+        traceLive(rect, isFixedRate() ? 0 : values(), sampleCount(), points);
+}
+
+/*!
+    \internal
+    Traces the live window, \a data are the points to trace or 0 for the
+    fixed-rate samples, see traceSamples().
+*/
+void QtBasicGraph::traceLive(const QRect &rect, const QPointF *data, int count, QVector<QPointF> *points) const
+{
+    TraceData samples = { data, 0, 0, count, 0, 0 };
+    if (!data) {
+        samples.samples = this->samples();
+        samples.x0 = sampleX(0);
+        samples.interval = m_sample_interval;
+    }
+    traceSamples(traceView(), rect, samples, points);
+}
+
+/*!
+    \internal
+    Returns the mapping of the current view to the widget.
+*/
+QtBasicGraph::TraceView QtBasicGraph::traceView() const
+{
+    const TraceView view = { width(), height(), viewRight() - m_view_range, m_view_range, m_ymin, m_ymax };
+    return view;
+}
+
+/*!
+    \internal
+    Traces the samples \a data through the part \a rect of \a view. The
+    visible samples are mapped to device coordinates in one pass. If there
+    are many more samples than pixel columns only the first, minimum,
+    maximum and last sample of every column is kept, which looks the same
+    but keeps the polyline short. The persistence mode accumulates the
+    hits of the same polyline.
+*/
+void QtBasicGraph::traceSamples(const TraceView &view, const QRect &rect, const TraceData &data,
+                                QVector<QPointF> *points)
+{
+    const int count = data.count;
+
+    auto bound = [&data, count](qreal x) {
+        if (data.points)
+            return int(std::lower_bound(data.points, data.points + count, x, QtBasicGraphLessX()) - data.points);
+        if (data.x)
+            return int(std::lower_bound(data.x, data.x + count, x) - data.x);
+        return qBound(0, qCeil((x - data.x0) / data.interval), count);
+    };
+
+    const qreal scalex = qreal(view.width) / view.range;
+    const qreal scaley = -qreal(view.height) / (view.ymax - view.ymin);
+    const qreal left = view.left;
+    const qreal ymax = view.ymax;
+
+    // 3 pixels margin, so lines leaving the rect are drawn completely
+    const int column0 = rect.left() - 3;
+    const int columns = rect.width() + 6;
+
+    const int first = qMax(0, bound(left + column0 / scalex) - 1);
+    const int last = qMin(count - 1, bound(left + (column0 + columns) / scalex));
+    const int visible = last - first + 1;
+
+    if (visible < 2)
+        return;
+
+    if (visible <= 4 * columns) {
+        points->resize(visible);
+        if (data.points) {
+            qtBasicGraphMapPoints(data.points + first, visible, left, ymax, scalex, scaley, points->data());
+        } else if (data.x) {
+            qtBasicGraphMapSamples(data.x + first, data.samples + first, visible, left, ymax, scalex, scaley,
+                                   points->data());
+        } else {
+            qtBasicGraphMapSamples(data.samples + first, visible, (data.x0 + first * data.interval - left) * scalex,
+                                   data.interval * scalex, ymax, scaley, points->data());
+        }
+        return;
+    }
+
+    points->reserve(4 * columns);
+
+    int begin = first;
+    for (int c = 0; c < columns && begin <= last; ++c) {
+        const int end = (c == columns - 1) ? last + 1
+                        : qBound(begin, bound(left + (column0 + c + 1) / scalex), last + 1);
+        if (end == begin)
+            continue;
+
+        qreal firsty, lasty, miny, maxy;
+        if (!data.points) {
+            const float *y = data.samples;
+            float low, high;
+            qtBasicGraphMinMax(y + begin, end - begin, &low, &high);
+            firsty = y[begin];
+            lasty = y[end - 1];
+            miny = low;
+            maxy = high;
+        } else {
+            const QPointF *v = data.points;
+            qtBasicGraphMinMax(v + begin, end - begin, &miny, &maxy);
+            firsty = v[begin].y();
+            lasty = v[end - 1].y();
+        }
+
+        const qreal x = column0 + c + qreal(0.5);
+        points->append(QPointF(x, (firsty - ymax) * scaley));
+        if (end - begin > 1) {
+            points->append(QPointF(x, (miny - ymax) * scaley));
+            points->append(QPointF(x, (maxy - ymax) * scaley));
+            points->append(QPointF(x, (lasty - ymax) * scaley));
+        }
+        begin = end;
+    }
+}
+
+/*!
+    \internal
+    Traces the part \a rect of the view from the history. Every pixel column
+    is drawn from its first, minimum, maximum and last value, so the cost
+    depends on the width of \a rect and not on the number of samples.
+*/
+void QtBasicGraph::traceHistory(const QRect &rect, QVector<QPointF> *points) const
+{
+    const int first = rect.left() - 1;
+    const int count = rect.width() + 2;
+    const qreal unitsPerPixel = m_view_range / width();
+    const qreal scaley = qreal(height()) / (m_ymax - m_ymin);
+    const qreal left = viewRight() - m_view_range;
+    const qreal x0 = left + first * unitsPerPixel;
+    const qreal x1 = left + (first + count) * unitsPerPixel;
+
+    QVarLengthArray<QtBasicGraphHistory::Column, 1024> columns(count);
+    m_history->columns(x0, x1, columns.data(), count);
+
+    points->reserve(4 * count + 2);
+
+    // connect to the samples outside of the painted columns
+    const qint64 before = m_history->lowerBound(x0) - 1;
+    if (before >= 0) {
+        const QPointF pt = m_history->at(before);
+        points->append(QPointF((pt.x() - left) / unitsPerPixel, (m_ymax - pt.y()) * scaley));
+    }
+
+    for (int c = 0; c < count; ++c) {
+        const QtBasicGraphHistory::Column &column = columns[c];
+        if (!column.count)
+            continue;
+
+        const qreal x = first + c + qreal(0.5);
+        points->append(QPointF(x, (m_ymax - column.first) * scaley));
+        if (column.count > 1) {
+            points->append(QPointF(x, (m_ymax - column.min) * scaley));
+            points->append(QPointF(x, (m_ymax - column.max) * scaley));
+            points->append(QPointF(x, (m_ymax - column.last) * scaley));
+        }
+    }
+
+    const qint64 after = m_history->lowerBound(x1);
+    if (after < m_history->count()) {
+        const QPointF pt = m_history->at(after);
+        points->append(QPointF((pt.x() - left) / unitsPerPixel, (m_ymax - pt.y()) * scaley));
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+#include "qtbasicgraphhistory.h"
+
+/*!
+    Enables or disables the crosshair, which follows the mouse and shows
+    the x and y value under it.
+*/
+void QtBasicGraph::setCrosshairEnabled(bool enabled)
+{
+    m_crosshair = enabled;
+    m_crosshair_visible = false;
+    m_overlay_region = QRegion();
+    setMouseTracking(enabled);
+    m_scroll_error = 0;
+    invalidate();
+}
+
+/*!
+    \internal
+    Draws the crosshair and the value readout computed by updateOverlay().
+*/
+void QtBasicGraph::drawOverlay(QPainter *painter)
+{
+    const QPoint pos = m_crosshair_pos;
+
+    painter->setPen(palette().color(QPalette::Highlight));
+    painter->drawLine(pos.x(), 0, pos.x(), height());
+    painter->drawLine(0, pos.y(), width(), pos.y());
+
+    if (!m_marker_rect.isEmpty())
+        painter->drawEllipse(m_marker_rect.adjusted(0, 0, -1, -1));
+
+    painter->fillRect(m_readout_rect, palette().color(QPalette::ToolTipBase));
+    painter->setPen(palette().color(QPalette::ToolTipText));
+    painter->drawText(m_readout_rect, Qt::AlignCenter, m_readout);
+}
+
+/*!
+    \internal
+    Looks up the sample nearest to the crosshair once and stores the
+    readout text, its rectangle below right of the mouse, flipped at the
+    widget edges, and the circle marking the sample. Repaints the area the
+    old and the new overlay cover.
+*/
+void QtBasicGraph::updateOverlay()
+{
+    const QRegion previous = m_overlay_region;
+    const QPoint pos = m_crosshair_pos;
+
+    QPointF sample;
+    const bool found = nearestSample(pos, &sample);
+    if (!found)
+        sample = mapToData(pos);
+    m_readout = QString("%1, %2").arg(sample.x(), 0, 'g', 6).arg(sample.y(), 0, 'g', 4);
+
+    m_marker_rect = QRect();
+    if (found) {
+        const QPoint center = mapFromData(sample).toPoint();
+        m_marker_rect = QRect(center - QPoint(3, 3), QSize(7, 7));
+    }
+
+    m_readout_rect = QRect(pos + QPoint(8, 8), fontMetrics().size(0, m_readout) + QSize(8, 4));
+    if (m_readout_rect.right() >= width())
+        m_readout_rect.moveRight(pos.x() - 8);
+    if (m_readout_rect.bottom() >= height())
+        m_readout_rect.moveBottom(pos.y() - 8);
+
+    m_overlay_region = QRegion(pos.x(), 0, 1, height());
+    m_overlay_region += QRect(0, pos.y(), width(), 1);
+    m_overlay_region += m_readout_rect;
+    m_overlay_region += m_marker_rect;
+    update(previous | m_overlay_region);
+}
+
+/*!
+    Finds the sample nearest in x to the widget position \a pos and stores it
+    in \a sample. If a model source with several y columns is shown the
+    trace closest to \a pos in y is taken and its index stored in \a trace.
+    Returns false if there is no data.
+
+    The live data, the history and the model data are ordered by x, so the
+    sample is found by a binary search in O(log n); in fixed-rate mode its
+    index is computed directly. The search runs on the stored samples, so
+    it gives the same answer however far the view is decimated.
+*/
+bool QtBasicGraph::nearestSample(const QPoint &pos, QPointF *sample, int *trace) const
+{
+    const QPointF target = mapToData(pos);
+    const qreal x = target.x();
+    QPointF found;
+    int series = 0;
+
+    if (m_source) {
+        const int count = m_source->count();
+        if (count == 0)
+            return false;
+
+        const qreal *xs = m_source->x();
+        int i = m_source->lowerBound(x);
+        if (i == count || (i > 0 && x - xs[i - 1] < xs[i] - x))
+            --i;
+
+        for (int s = 0; s < m_source->seriesCount(); ++s) {
+            const QPointF point = m_source->point(s, i);
+            if (s == 0 || qAbs(point.y() - target.y()) < qAbs(found.y() - target.y())) {
+                found = point;
+                series = s;
+            }
+        }
+    } else if (usesHistory()) {
+        const qint64 count = m_history->count();
+        qint64 i = m_history->lowerBound(x);
+        if (i == count || (i > 0 && x - m_history->at(i - 1).x() < m_history->at(i).x() - x))
+            --i;
+        found = m_history->at(i);
+    } else if (isFixedRate()) {
+        if (sampleCount() == 0)
+            return false;
+
+        const int i = qBound(0, qRound((x - sampleX(0)) / m_sample_interval), sampleCount() - 1);
+        found = QPointF(sampleX(i), samples()[i]);
+    } else {
+        const int count = sampleCount();
+        if (count == 0)
+            return false;
+
+        const QPointF *v = values();
+        int i = lowerBound(x);
+        if (i == count || (i > 0 && x - v[i - 1].x() < v[i].x() - x))
+            --i;
+        found = v[i];
+    }
+
+    *sample = found;
+    if (trace)
+        *trace = series;
+    return true;
+}
+
+/*!
+    Returns the widget position of the data point \a sample in the current
+    view.
+*/
+QPointF QtBasicGraph::mapFromData(const QPointF &sample) const
+{
+    const qreal left = viewRight() - m_view_range;
+    return QPointF((sample.x() - left) * width() / m_view_range,
+                   (m_ymax - sample.y()) * height() / (m_ymax - m_ymin));
+}
+
+/*!
+    Returns the data point at the widget position \a pos in the current view.
+*/
+QPointF QtBasicGraph::mapToData(const QPoint &pos) const
+{
+    return QPointF(viewRight() - (width() - pos.x()) * m_view_range / width(),
+                   m_ymax - pos.y() * (m_ymax - m_ymin) / height());
+}
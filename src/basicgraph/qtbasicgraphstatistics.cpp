@@ -0,0 +1,251 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+
+/*!
+    Enables or disables the auto range. While enabled the y range follows
+    the minimum and maximum of the data in the last xRange().
+*/
+void QtBasicGraph::setAutoRange(bool enabled)
+{
+    m_auto_range = enabled;
+    rebuildRange();
+
+    if (updateAutoRange()) {
+        m_scroll_error = 0;
+        invalidate();
+    }
+}
+
+/*!
+    Sets the \a hysteresis of the auto range as a fraction of the data
+    range. The range gets a margin of this fraction above and below the data
+    and is only narrowed again when it is more than 1 + 2 * \a hysteresis
+    times as large as needed. The default is 0.1.
+*/
+void QtBasicGraph::setAutoRangeHysteresis(qreal hysteresis)
+{
+    m_auto_range_hysteresis = qMax(hysteresis, qreal(0));
+}
+
+/*!
+    Enables or disables the statistics of the data in the last xRange(),
+    see mean(), standardDeviation(), minimum(), maximum() and
+    statisticsChanged().
+*/
+void QtBasicGraph::setStatisticsEnabled(bool enabled)
+{
+    m_statistics = enabled;
+    rebuildRange();
+    if (enabled)
+        scheduleStatistics();
+}
+
+/*!
+    Returns the mean of the samples in the live window.
+*/
+qreal QtBasicGraph::mean() const
+{
+    return m_stats_mean;
+}
+
+/*!
+    Returns the sample standard deviation of the live window.
+*/
+qreal QtBasicGraph::standardDeviation() const
+{
+    return m_stats_count > 1 ? qSqrt(qMax(m_stats_m2, 0.0) / (m_stats_count - 1)) : qreal(0);
+}
+
+/*!
+    Returns the smallest sample in the live window.
+*/
+qreal QtBasicGraph::minimum() const
+{
+    return m_range_min.empty() ? qreal(0) : qreal(m_range_min.front().value);
+}
+
+/*!
+    Returns the largest sample in the live window.
+*/
+qreal QtBasicGraph::maximum() const
+{
+    return m_range_max.empty() ? qreal(0) : qreal(m_range_max.front().value);
+}
+
+/*!
+    \internal
+    Adds the sample \a y with the running number \a serial to the auto
+    range queues, see trackExtremes(). With statistics enabled the sample
+    is also added to the running mean.
+*/
+void QtBasicGraph::trackRange(qint64 serial, float y)
+{
+    if (m_statistics) {
+        const double delta = y - m_stats_mean;
+        m_stats_mean += delta / ++m_stats_count;
+        m_stats_m2 += delta * (y - m_stats_mean);
+    }
+
+    trackExtremes(serial, y);
+}
+
+/*!
+    \internal
+    Adds the sample \a y with the running number \a serial to the auto
+    range queues only. Samples that can no longer become the minimum or
+    maximum because a newer sample is at least as small or large are
+    dropped.
+*/
+void QtBasicGraph::trackExtremes(qint64 serial, float y)
+{
+    const RangeEntry entry = { serial, y };
+
+    while (!m_range_min.empty() && m_range_min.back().value >= y)
+        m_range_min.pop_back();
+    m_range_min.push_back(entry);
+
+    while (!m_range_max.empty() && m_range_max.back().value <= y)
+        m_range_max.pop_back();
+    m_range_max.push_back(entry);
+}
+
+/*!
+    \internal
+    Removes the \a count oldest samples, which are about to be purged, from
+    the running mean.
+*/
+void QtBasicGraph::untrackRange(int count)
+{
+    if (!m_statistics)
+        return;
+
+    for (int i = 0; i < count && m_stats_count > 1; ++i) {
+        double y;
+        if (m_source)
+            y = m_source->y(0)[m_source_first + i];
+        else if (isFixedRate())
+            y = samples()[i];
+        else
+            y = float(values()[i].y());
+        const double delta = y - m_stats_mean;
+        m_stats_mean -= delta / --m_stats_count;
+        m_stats_m2 -= delta * (y - m_stats_mean);
+    }
+}
+
+/*!
+    \internal
+    Fills the auto range queues and the running mean again from all samples
+    of the live window. Purging calls this when it compacts the samples, so
+    rounding errors of the removed samples cannot accumulate.
+*/
+void QtBasicGraph::rebuildRange()
+{
+    m_range_min.clear();
+    m_range_max.clear();
+    m_stats_count = 0;
+    m_stats_mean = 0;
+    m_stats_m2 = 0;
+
+    if (!m_auto_range && !m_statistics)
+        return;
+
+    const qint64 first = firstSerial();
+    if (m_source) {
+        for (int i = 0; i < liveCount(); ++i)
+            trackSourceRow(m_source_first + i);
+        return;
+    }
+
+    for (int i = 0; i < sampleCount(); ++i) {
+        if (isFixedRate())
+            trackRange(first + i, samples()[i]);
+        else
+            trackRange(first + i, float(values()[i].y()));
+    }
+}
+
+/*!
+    \internal
+    Drops purged samples from the front of the auto range queues.
+*/
+void QtBasicGraph::dropRange()
+{
+    const qint64 first = firstSerial();
+    while (!m_range_min.empty() && m_range_min.front().serial < first)
+        m_range_min.pop_front();
+    while (!m_range_max.empty() && m_range_max.front().serial < first)
+        m_range_max.pop_front();
+}
+
+/*!
+    \internal
+    Emits statisticsChanged() with the next frame, so it is sent at most
+    once per screen refresh.
+*/
+void QtBasicGraph::scheduleStatistics()
+{
+    if (m_stats_timer.isActive())
+        return;
+
+    // the window has no native handle before it is shown
+    const QWindow *handle = window()->windowHandle();
+    const QScreen *screen = handle ? handle->screen() : QGuiApplication::primaryScreen();
+    const qreal rate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : qreal(60);
+    m_stats_timer.start(qMax(1, qRound(1000 / rate)), this);
+}
+
+/*!
+    \overload
+    \internal
+    Emits the rate limited statisticsChanged().
+*/
+void QtBasicGraph::timerEvent(QTimerEvent *e)
+{
+    if (e->timerId() != m_stats_timer.timerId()) {
+        QWidget::timerEvent(e);
+        return;
+    }
+
+    m_stats_timer.stop();
+    emit statisticsChanged(mean(), standardDeviation(), minimum(), maximum());
+}
+
+/*!
+    \internal
+    Drops purged samples from the auto range queues and adjusts the y range
+    if the data left it or fills too little of it. Returns true if the
+    range changed.
+*/
+bool QtBasicGraph::updateAutoRange()
+{
+    if (!m_auto_range || m_range_min.empty())
+        return false;
+
+    dropRange();
+
+    const qreal low = m_range_min.front().value;
+    const qreal high = m_range_max.front().value;
+    const qreal h = m_auto_range_hysteresis;
+
+    // a flat signal still needs a range around it
+    qreal pad = (high - low) * h;
+    if (high <= low)
+        pad = qAbs(high) > 0 ? qAbs(high) * qMax(h, qreal(0.1)) : qreal(1);
+
+    const qreal span = high - low + 2 * pad;
+    if (low >= m_ymin && high <= m_ymax && (m_ymax - m_ymin) <= span * (1 + 2 * h))
+        return false;
+
+    m_ymin = low - pad;
+    m_ymax = high + pad;
+    emit yRangeChanged(m_ymin, m_ymax);
+    return true;
+}
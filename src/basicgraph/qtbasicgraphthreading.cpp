@@ -0,0 +1,205 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+/*!
+    \internal
+    Traces and renders the whole trace layer from a snapshot of the view.
+    It runs on the render thread and only uses its own references to the
+    implicitly shared sample arrays, which the graph detaches from when it
+    changes them.
+*/
+class QtBasicGraph::RenderJob : public QRunnable
+{
+public:
+    // the samples from first to first + count - 1 of either values or
+    // samples with the x values x or x0 + index * interval, or the already
+    // traced points if count is 0
+    struct Series {
+        QVector<QPointF> values;
+        QVector<float> samples;
+        QVector<qreal> x;
+        int first;
+        int count;
+        qreal x0;
+        qreal interval;
+        QVector<QPointF> points;
+        TraceStyle style;
+    };
+
+    void run();
+
+    QtBasicGraph *graph;
+    qint64 generation;
+    TraceView view;
+    QSize size;
+    qreal dpr;
+    QPainter::RenderHints hints;
+    bool fastRaster;
+    QVector<Series> series;
+};
+
+void QtBasicGraph::RenderJob::run()
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(0);
+
+    const QRect rect(0, 0, view.width, view.height);
+    QVector<QPointF> buffer;
+    QPainter p;
+
+    for (int i = 0; i < series.size(); ++i) {
+        Series &s = series[i];
+        if (s.count < 2)
+            continue;
+
+        const TraceData data = { s.values.isEmpty() ? 0 : s.values.constData() + s.first,
+                                 s.x.isEmpty() ? 0 : s.x.constData() + s.first,
+                                 s.samples.isEmpty() ? 0 : s.samples.constData() + s.first,
+                                 s.count, s.x0, s.interval };
+        traceSamples(view, rect, data, &s.points);
+    }
+
+    if (!fastRaster) {
+        p.begin(&image);
+        if (hints)
+            p.setRenderHints(hints);
+    }
+
+    for (int i = 0; i < series.size(); ++i) {
+        const Series &s = series.at(i);
+
+        if (fastRaster) {
+            rasterizeTrace(reinterpret_cast<quint32 *>(image.bits()), image.bytesPerLine() / 4,
+                           image.width(), image.height(), s.style, s.points, 0, 0, &buffer);
+        } else {
+            paintTrace(&p, rect, s.style, s.points, &buffer);
+        }
+    }
+
+    if (p.isActive())
+        p.end();
+
+    // the graph waits for the job before it is destroyed
+    QMetaObject::invokeMethod(graph, "renderFinished", Qt::QueuedConnection, Q_ARG(QImage, image),
+                              Q_ARG(qint64, generation));
+}
+
+/*!
+    \internal
+    Starts a render job with a snapshot of the view, or remembers the
+    request if a job is still running. The snapshot only references the
+    sample arrays, so the GUI thread neither copies nor traces the visible
+    samples; only the history, whose columns are bounded by the width, is
+    traced here.
+*/
+void QtBasicGraph::startRender()
+{
+    if (m_render_running) {
+        m_render_pending = true;
+        return;
+    }
+
+    RenderJob *job = new RenderJob;
+    job->graph = this;
+    job->generation = ++m_render_generation;
+    job->view = traceView();
+    job->dpr = devicePixelRatioF();
+    job->size = size() * job->dpr;
+    job->hints = m_render_hints;
+    job->fastRaster = useFastRaster();
+
+    job->series.resize(traceCount());
+    for (int i = 0; i < job->series.size(); ++i) {
+        RenderJob::Series &series = job->series[i];
+        series.first = 0;
+        series.count = 0;
+        series.x0 = 0;
+        series.interval = 0;
+        series.style = traceStyle(i);
+
+        if (m_source) {
+            series.x = m_source->m_x;
+            series.samples = m_source->m_series.at(i);
+            series.first = m_source->m_head;
+            series.count = m_source->count();
+        } else if (showsCapture() && !m_capture.isEmpty()) {
+            series.values = m_capture;
+            series.count = m_capture.size();
+        } else if (usesHistory()) {
+            traceHistory(rect(), &series.points);
+        } else if (isFixedRate()) {
+            series.samples = m_samples;
+            series.first = m_sample_offset;
+            series.count = sampleCount();
+            series.x0 = sampleX(0);
+            series.interval = m_sample_interval;
+        } else {
+            series.values = m_values;
+            series.first = m_value_offset;
+            series.count = sampleCount();
+        }
+    }
+
+    m_render_running = true;
+    m_render_pending = false;
+    m_render_pool->start(job);
+}
+
+/*!
+    \internal
+    Shows the \a image of the finished render job \a generation and starts
+    the next one if data arrived in the meantime. The images of jobs that
+    were started before the graph was resized or threaded rendering was
+    switched off and on again are dropped.
+*/
+void QtBasicGraph::renderFinished(const QImage &image, qint64 generation)
+{
+    // a job from before threaded rendering was switched on again
+    if (!m_threaded || generation != m_render_generation)
+        return;
+
+    m_render_running = false;
+    if (generation > m_render_stale) {
+        m_trace_layer = image;
+        update();
+    }
+
+    if (m_render_pending)
+        startRender();
+}
+
+/*!
+    Enables or disables rendering the trace on a worker thread. Every graph
+    uses its own thread, so several graphs render in parallel. The
+    persistence mode is not available with threaded rendering.
+*/
+void QtBasicGraph::setThreadedRendering(bool enabled)
+{
+    if (enabled == m_threaded)
+        return;
+
+    m_threaded = enabled;
+    if (enabled && !m_render_pool) {
+        m_render_pool = new QThreadPool;
+        m_render_pool->setMaxThreadCount(1);
+    } else if (!enabled && m_render_pool) {
+        m_render_pool->waitForDone();
+    }
+
+    m_render_running = false;
+    m_render_pending = false;
+    m_render_stale = m_render_generation;
+    m_trace_layer = QImage();
+    m_scroll_error = 0;
+    invalidate();
+}
@@ -0,0 +1,141 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+#include "qtbasicgraph.h"
+#include "qtbasicgraphkernels.h"
+
+/*!
+    \internal
+    Searches the samples added since the last call for the trigger and
+    shows the capture once all of its samples have arrived. After a capture
+    the search continues behind it unless the trigger is single shot.
+*/
+void QtBasicGraph::updateTrigger()
+{
+    const qint64 first = firstSerial();
+    const int count = liveCount();
+    const bool rising = m_trigger_mode == RisingEdge;
+
+    forever {
+        if (m_trigger_pending) {
+            const qreal right = m_trigger_x + (1 - m_trigger_position) * m_view_range;
+            if (count == 0 || lastX() < right)
+                return;
+
+            m_trigger_pending = false;
+            m_capture_valid = true;
+            m_capture_right = right;
+            m_capture_fresh = true;
+            m_capture.clear();
+            m_scroll_error = 0;
+            invalidate();
+            emit triggered(m_trigger_x);
+
+            if (m_trigger_single)
+                return;
+
+            // hold off until the end of the capture
+            m_trigger_armed = true;
+            m_trigger_serial = qMax(m_trigger_serial, first + lowerBound(right));
+        }
+
+        if (!m_trigger_armed)
+            return;
+
+        // the crossing is tested against the sample before the first new one
+        const int begin = int(qMax(m_trigger_serial - first, qint64(1)));
+        if (begin >= count) {
+            m_trigger_serial = qMax(m_trigger_serial, first + count);
+            return;
+        }
+
+        // the first trace of a source is searched like fixed-rate samples
+        const float *y = m_source ? m_source->y(0) + m_source_first : samples();
+        int i = m_source || isFixedRate()
+                ? qtBasicGraphFindCrossing(y + begin - 1, count - begin + 1, float(m_trigger_level), rising)
+                : qtBasicGraphFindCrossing(values() + begin - 1, count - begin + 1, m_trigger_level, rising);
+        if (i < 0) {
+            m_trigger_serial = first + count;
+            return;
+        }
+        i += begin - 1;
+
+        // the crossing is interpolated, so captures do not jitter by a sample
+        const QPointF a = liveSample(i - 1);
+        const QPointF b = liveSample(i);
+        const qreal t = b.y() != a.y() ? (m_trigger_level - a.y()) / (b.y() - a.y()) : qreal(0);
+
+        m_trigger_x = a.x() + t * (b.x() - a.x());
+        m_trigger_armed = false;
+        m_trigger_pending = true;
+        m_trigger_serial = first + i + 1;
+    }
+}
+
+/*!
+    \internal
+    Copies the samples of the shown capture out of the live window.
+*/
+void QtBasicGraph::copyCapture()
+{
+    const int first = qMax(0, lowerBound(m_capture_right - m_view_range) - 1);
+    const int last = qMin(sampleCount() - 1, lowerBound(m_capture_right));
+
+    for (int i = first; i <= last; ++i)
+        m_capture.append(liveSample(i));
+}
+
+/*!
+    Switches to triggered mode, where a capture of the view range is shown
+    whenever the data crosses \a level in the direction given by \a mode.
+    NoTrigger returns to the continuously scrolling view.
+*/
+void QtBasicGraph::setTrigger(TriggerMode mode, qreal level)
+{
+    m_trigger_mode = mode;
+    m_trigger_level = level;
+    m_capture_valid = false;
+    m_capture.clear();
+    armTrigger();
+
+    // the samples already held are searched as well
+    m_trigger_serial = firstSerial();
+    updateTrigger();
+    m_scroll_error = 0;
+    invalidate();
+}
+
+/*!
+    Sets the part of the view range before the trigger to \a position,
+    from 0 for a trigger at the left edge to 1 for one at the right edge.
+    The default is 0.5.
+*/
+void QtBasicGraph::setTriggerPosition(qreal position)
+{
+    m_trigger_position = qBound(qreal(0), position, qreal(1));
+}
+
+/*!
+    In single shot mode the first capture is frozen until armTrigger() is
+    called, otherwise every trigger refreshes the view.
+*/
+void QtBasicGraph::setTriggerSingleShot(bool singleShot)
+{
+    m_trigger_single = singleShot;
+}
+
+/*!
+    Starts waiting for the next trigger. The current capture stays visible
+    until it is replaced.
+*/
+void QtBasicGraph::armTrigger()
+{
+    m_trigger_pending = false;
+    m_trigger_armed = m_trigger_mode != NoTrigger;
+    m_trigger_serial = firstSerial() + liveCount();
+}
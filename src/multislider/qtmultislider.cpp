@@ -7,20 +7,47 @@
 */
 
 #include <QtCore/QDebug>
+#include <QtCore/qmath.h>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QPainter>
 #include <QtSvg/QSvgRenderer>
 
 #include "qtmultislider.h"
 
+#include <algorithm>
+
+/*!
+    \internal
+    Returns the pixel of the center of \a bin out of \a bins, counted from
+    the bottom of a strip with \a span pixels between its bottom and top
+    row. This is the mapping of valueToPixel() for the bins.
+*/
+static int histogramBinCenter(int bin, int bins, int span)
+{
+    return bins > 1 ? qRound(qreal(bin) * span / (bins - 1)) : 0;
+}
+
+/*!
+    \internal
+    Stores the lowest and highest pixel of \a bin in \a low and \a high, see
+    histogramBinCenter(). Every bin reaches half way to its neighbours, with
+    more bins than pixels some bins are empty.
+*/
+static void histogramBinPixels(int bin, int bins, int span, int *low, int *high)
+{
+    const int center = histogramBinCenter(bin, bins, span);
+    *low = bin > 0 ? (histogramBinCenter(bin - 1, bins, span) + center) / 2 + 1 : 0;
+    *high = bin < bins - 1 ? (center + histogramBinCenter(bin + 1, bins, span)) / 2 : span;
+}
+
 /*!
 
     \class QtMultiSlider qtmultislider.h
 
     The description of the QtMultiSlider.
 
-    \brief The QtMultiSlider class provides a double slider with SVG
-    graphics.
+    \brief The QtMultiSlider class provides a vertical level display with
+    threshold sliders and SVG graphics.
 
     The QtMultiSlider is an example to show the capabilities of the Qt Framework
     related to customized controls.
@@ -52,24 +79,71 @@
 
     The current skin can be read over the \a skin() function.
 
-    \sa skin(), setSkin()
+    The widget keeps its value in a plain range and value model, so
+    setValue() for a high-rate display only stores the value, checks the
+    thresholds it passed and repaints the changed band of the value bar.
+    Unlike the QProgressBar this class was based on before, a value outside
+    of the range is not ignored but moved to the nearest bound, so it still
+    shows as an exceeded limit. The upper and lower slider are thresholds
+    now; topSlider() and bottomSlider() are only kept for compatibility.
+
+    The slider has a lower and an upper limit by default. Any number of
+    further thresholds can be added with addThreshold(), for example a
+    low-low, low, high and high-high alarm limit:
+
+    \code
+
+        slider->clearThresholds();
+        slider->addThreshold(5, QtMultiSlider::LowerLimit);
+        slider->addThreshold(20, QtMultiSlider::LowerLimit);
+        slider->addThreshold(80, QtMultiSlider::UpperLimit);
+        slider->addThreshold(95, QtMultiSlider::UpperLimit);
 
+    \endcode
+
+    The thresholds are kept ordered by value and cannot be dragged past
+    each other, so the index of a threshold does not change while it is
+    moved. An upper limit is exceeded if the value is above it, a lower
+    limit if the value is below it. A value change only checks the
+    thresholds between the old and the new value.
+
+    A noisy value near a threshold can be kept from toggling its state with
+    setHysteresis(), which widens the band the value has to cross back, and
+    with setHoldTime(), which keeps a state for at least the given time.
+    With a hold time each threshold sends at most one thresholdExceeded()
+    per hold time, however often the value changes.
+
+    With setHistogramEnabled() the groove shows how long the value stayed
+    at each level, with older samples fading out after
+    histogramHalfLife() samples. It is updated with every setValue() call,
+    also if the value did not change, and only repaints the bins that
+    changed.
 
     Signals: \n
 
+    \fn void thresholdChanged(int index, int value)
+    \fn void thresholdExceeded(int index, bool exceeded)
     \fn void maximumExceeded()
     \fn void minimumExceeded()
 
     Slots: \n
 
+    \fn void setThresholdValue()
     \fn void setMaximumRange()
     \fn void setMinimumRange()
     \fn void setValue()
 
+    \sa skin(), setSkin()
+
 */
 
-/*! \class QtMultiSliderHelper qtmultiSlider.h
-    \brief Private class of QtMultiSlider
+/*! \class QtMultiSliderHelper qtmultislider.h
+    \brief Deprecated slider that mirrors the lowest upper or the highest
+    lower limit of a QtMultiSlider, see QtMultiSlider::topSlider().
+
+    The helper is never shown. Its range follows the range of the multi
+    slider, setting its value moves the limit and moving the limit sets
+    its value.
 */
 
 QtMultiSliderHelper::QtMultiSliderHelper(QWidget * parent)
@@ -88,7 +162,7 @@ void QtMultiSliderHelper::paintEvent(QPaintEvent * event)
 }
 
 QtMultiSlider::QtMultiSlider(QWidget * parent)
-        : QProgressBar(parent)
+        : QWidget(parent)
 {
     init();
 }
@@ -130,12 +204,9 @@ void QtMultiSlider::setSkin(const QString& skin)
     m_rendererBottomSliderPressed->load(base + "slider_min_pressed.svg");
     m_rendererGroove->load(base + "groove.svg");
 
-    m_topSliderRenderer = m_rendererTopSlider;
-    m_bottomSliderRenderer = m_rendererBottomSlider;
-
     // update geometry for new sizeHint and repaint
     updateGeometry();
-    update();
+    updateLayout();
 }
 
 /*!
@@ -165,6 +236,20 @@ void QtMultiSlider::init()
     m_previousExceededMaximum = false;
     m_previousExceededMinimum = false;
     m_dragInProgress = false;
+    m_minimum = 0;
+    m_maximum = 100;
+    m_value = 0;
+    m_hovered = -1;
+    m_pressed = -1;
+    m_hysteresis = 0;
+    m_holdTime = 0;
+    m_histogramEnabled = false;
+    m_histogramHalfLife = 0;
+    m_histogramIncrement = 1;
+    m_histogramMaximum = 0;
+    m_histogramReference = 0;
+    m_holdDeadline = 0;
+    m_clock.start();
 
     m_rendererValueBar = new QtSvgPixmapCache(this);
     m_rendererValueBarFilled = new QtSvgPixmapCache(this);
@@ -178,223 +263,951 @@ void QtMultiSlider::init()
     m_rendererBottomSliderPressed = new QtSvgPixmapCache(this);
     m_rendererGroove = new QtSvgPixmapCache(this);
 
-    m_topSliderRenderer = m_rendererTopSlider;
-    m_bottomSliderRenderer = m_rendererBottomSlider;
-
     // Prepare for mouse over ( "hover") detection
     setMouseTracking(true);
     setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
 
-    m_topSlider = new QtMultiSliderHelper(this);
-    m_topSlider->setValue(maximum());
-    m_topSlider->setMaximum(maximum());
-    m_topSlider->setMinimum(minimum());
+    // the default lower and upper limit, neither is exceeded by the
+    // initial value at the minimum
+    const Handle bottom = { minimum(), LowerLimit, false, false, 0, QRect(), 0 };
+    const Handle top = { maximum(), UpperLimit, false, false, 0, QRect(), 0 };
+    m_handles.append(bottom);
+    m_handles.append(top);
+    updateRangeIndexes();
+    setHistogramHalfLife(1000);
+}
 
-    m_bottomSlider = new QtMultiSliderHelper(this);
-    m_bottomSlider->setValue(minimum());
-    m_bottomSlider->setMaximum(maximum());
-    m_bottomSlider->setMinimum(minimum());
+/*!
+    Adds a threshold of the given \a type at \a value and returns its index.
+    The thresholds are ordered by value, so the indexes of the thresholds
+    above it grow by one. The value is bound to the range of the slider.
 
-    connect(m_topSlider, SIGNAL(valueChanged(int)), SLOT(checkMaximumRange(int)));
-    connect(m_bottomSlider, SIGNAL(valueChanged(int)), SLOT(checkMinimumRange(int)));
+    \sa removeThreshold(), thresholdExceeded()
+*/
+int QtMultiSlider::addThreshold(int value, ThresholdType type)
+{
+    value = qBound(minimum(), value, maximum());
+    const int index = std::upper_bound(m_handles.constBegin(), m_handles.constEnd(), value,
+                                       [](int value, const Handle &handle) { return value < handle.value; })
+                      - m_handles.constBegin();
+
+    const Handle handle = { value, type, false, false, 0, QRect(), 0 };
+    m_handles.insert(index, handle);
+    if (m_hovered >= index)
+        ++m_hovered;
+    if (m_pressed >= index)
+        ++m_pressed;
+
+    updateRangeIndexes();
+    updateThresholdLayout(index);
+    checkThreshold(index);
+    checkRangeExceeded();
+    return index;
 }
 
 /*!
-    Returns the top slider
+    Removes the threshold at \a index. The indexes of the thresholds above
+    it shrink by one.
+*/
+void QtMultiSlider::removeThreshold(int index)
+{
+    if (index < 0 || index >= m_handles.size())
+        return;
+
+    update(m_handles.at(index).rect);
+    m_handles.remove(index);
+
+    if (m_hovered == index)
+        m_hovered = -1;
+    else if (m_hovered > index)
+        --m_hovered;
+    if (m_pressed == index) {
+        m_pressed = -1;
+        m_dragInProgress = false;
+    } else if (m_pressed > index) {
+        --m_pressed;
+    }
+
+    updateRangeIndexes();
+    checkRangeExceeded();
+}
+
+/*!
+    Removes all thresholds, including the default lower and upper limit.
+*/
+void QtMultiSlider::clearThresholds()
+{
+    foreach (const Handle &handle, m_handles)
+        update(handle.rect);
+
+    m_handles.clear();
+    m_hovered = -1;
+    m_pressed = -1;
+    m_dragInProgress = false;
+
+    updateRangeIndexes();
+    checkRangeExceeded();
+}
+
+/*!
+    Returns the number of thresholds.
+*/
+int QtMultiSlider::thresholdCount() const
+{
+    return m_handles.size();
+}
+
+/*!
+    Returns the value of the threshold at \a index.
+*/
+int QtMultiSlider::thresholdValue(int index) const
+{
+    return m_handles.at(index).value;
+}
+
+/*!
+    Returns the type of the threshold at \a index.
+*/
+QtMultiSlider::ThresholdType QtMultiSlider::thresholdType(int index) const
+{
+    return m_handles.at(index).type;
+}
+
+/*!
+    Returns true if the value exceeds the threshold at \a index.
+*/
+bool QtMultiSlider::isThresholdExceeded(int index) const
+{
+    return m_handles.at(index).exceeded;
+}
+
+/*!
+    Returns the index of the threshold handle at \a pos, or -1 if there is
+    none. If handles overlap, the one painted last wins.
+
+    The handles are found with a binary search over their lines, so only
+    the handles near \a pos are tested.
+*/
+int QtMultiSlider::thresholdAt(const QPoint &pos) const
+{
+    const int lowest = pos.y() - m_layout.bottomSliderSize.height();
+
+    int found = -1;
+    for (int i = firstThresholdBelow(pos.y()); i < m_handles.size() && m_handles.at(i).line > lowest; ++i) {
+        if (m_handles.at(i).rect.contains(pos))
+            found = i;
+    }
+    return found;
+}
+
+/*!
+    \internal
+    Returns the index of the first handle that can reach up to \a y or
+    further, which is the first one whose line is at most the height of an
+    upper handle below \a y.
+*/
+int QtMultiSlider::firstThresholdBelow(int y) const
+{
+    const int line = y + m_layout.topSliderSize.height();
+    return std::lower_bound(m_handles.constBegin(), m_handles.constEnd(), line,
+                            [](const Handle &handle, int line) { return handle.line > line; })
+           - m_handles.constBegin();
+}
+
+/*!
+    \deprecated
+    Returns a slider that follows the lowest upper limit, use
+    maximumRange() and setMaximumRange() instead.
 */
 QtMultiSliderHelper * QtMultiSlider::topSlider()
 {
+    if (!m_topSlider)
+        m_topSlider = createHelper(maximumRange(), SLOT(setMaximumRange(int)));
     return m_topSlider;
 }
 
 /*!
-    Returns the bottom slider
+    \deprecated
+    Returns a slider that follows the highest lower limit, use
+    minimumRange() and setMinimumRange() instead.
 */
 QtMultiSliderHelper * QtMultiSlider::bottomSlider()
 {
+    if (!m_bottomSlider)
+        m_bottomSlider = createHelper(minimumRange(), SLOT(setMinimumRange(int)));
     return m_bottomSlider;
 }
 
 /*!
-    Set the actual vlaue
+    \internal
+    Creates a hidden helper slider at \a value whose value changes call
+    \a slot.
 */
-void QtMultiSlider::setValue(int value)
+QtMultiSliderHelper * QtMultiSlider::createHelper(int value, const char *slot)
 {
-    QProgressBar::setValue(value);
+    QtMultiSliderHelper *helper = new QtMultiSliderHelper(this);
+    helper->hide();
+    helper->setRange(minimum(), maximum());
+    helper->setValue(value);
+    connect(helper, SIGNAL(valueChanged(int)), this, slot);
+    return helper;
+}
 
-    checkMaximumRange(topSlider()->value());
-    checkMinimumRange(bottomSlider()->value());
+/*!
+    \internal
+    Moves the helper sliders to the range and the limits. A helper that
+    already has the value does not emit valueChanged(), and setting a limit
+    to its own value does nothing, so the two cannot call each other in a
+    loop.
+*/
+void QtMultiSlider::updateHelpers()
+{
+    if (m_topSlider) {
+        m_topSlider->setRange(minimum(), maximum());
+        m_topSlider->setValue(maximumRange());
+    }
+    if (m_bottomSlider) {
+        m_bottomSlider->setRange(minimum(), maximum());
+        m_bottomSlider->setValue(minimumRange());
+    }
 }
 
 /*!
-    Check if the top slider value is bigger than the actual value.
-    If true send the signal maximumExceeded(bool).
+    Returns the lowest upper limit, or maximum() if there is no upper limit.
 */
-void QtMultiSlider::checkMaximumRange(int topSliderValue)
+int QtMultiSlider::maximumRange() const
 {
-    const bool exceeded = value() > topSliderValue;
-    if (m_previousExceededMaximum != exceeded) {
-        m_previousExceededMaximum = exceeded;
-        emit maximumExceeded(exceeded);
+    return m_maximumIndex >= 0 ? m_handles.at(m_maximumIndex).value : maximum();
+}
+
+/*!
+    Returns the highest lower limit, or minimum() if there is no lower limit.
+*/
+int QtMultiSlider::minimumRange() const
+{
+    return m_minimumIndex >= 0 ? m_handles.at(m_minimumIndex).value : minimum();
+}
+
+/*!
+    Sets the hysteresis of all thresholds to \a hysteresis. An exceeded
+    upper limit is only cleared when the value falls to the limit minus the
+    hysteresis, an exceeded lower limit when the value rises to the limit
+    plus the hysteresis. The default is 0.
+
+    \sa setHoldTime()
+*/
+void QtMultiSlider::setHysteresis(int hysteresis)
+{
+    m_hysteresis = qMax(0, hysteresis);
+
+    checkThresholds(minimum(), maximum());
+    checkRangeExceeded();
+}
+
+/*!
+    Returns the hysteresis of the thresholds.
+*/
+int QtMultiSlider::hysteresis() const
+{
+    return m_hysteresis;
+}
+
+/*!
+    Sets the minimum time in milliseconds the exceeded state of a threshold
+    is held to \a msecs. A change within this time is delayed until it is
+    over and dropped if the value returned in the meantime. The default is
+    0, which reports every change at once. A new hold time applies to the
+    following changes.
+
+    \sa setHysteresis()
+*/
+void QtMultiSlider::setHoldTime(int msecs)
+{
+    m_holdTime = qMax(0, msecs);
+}
+
+/*!
+    Returns the hold time of the exceeded states in milliseconds.
+*/
+int QtMultiSlider::holdTime() const
+{
+    return m_holdTime;
+}
+
+/*!
+    Shows or hides the histogram of the value in the groove. The histogram
+    is cleared when it is enabled.
+
+    \sa setHistogramHalfLife()
+*/
+void QtMultiSlider::setHistogramEnabled(bool enabled)
+{
+    if (m_histogramEnabled == enabled)
+        return;
+
+    m_histogramEnabled = enabled;
+    clearHistogram();
+}
+
+/*!
+    Returns true if the histogram is shown.
+*/
+bool QtMultiSlider::isHistogramEnabled() const
+{
+    return m_histogramEnabled;
+}
+
+/*!
+    Sets the number of samples after which the weight of a sample in the
+    histogram has halved to \a samples. The default is 1000.
+*/
+void QtMultiSlider::setHistogramHalfLife(int samples)
+{
+    m_histogramHalfLife = qMax(1, samples);
+    m_histogramGrowth = qPow(2, qreal(1) / m_histogramHalfLife);
+}
+
+/*!
+    Returns the half-life of the histogram in samples.
+*/
+int QtMultiSlider::histogramHalfLife() const
+{
+    return m_histogramHalfLife;
+}
+
+/*!
+    Removes all samples from the histogram.
+*/
+void QtMultiSlider::clearHistogram()
+{
+    m_histogram.clear();
+    m_histogramIncrement = 1;
+    m_histogramMaximum = 0;
+    m_histogramReference = 0;
+    if (m_histogramEnabled)
+        m_histogram.fill(0, int(qMin(qint64(m_maximum) - m_minimum + 1, qint64(MaxHistogramBins))));
+
+    updateHistogramStrip();
+    update(m_layout.histogram);
+}
+
+/*!
+    \internal
+    Adds \a value to the histogram. Instead of decaying all bins, the
+    weight of a new sample grows, which keeps the ratios the same. Only the
+    bin of the value changes; all bins are scaled down together once every
+    32 half-lives, before the weights get too large.
+
+    The bars are drawn relative to the largest bin, so the display does not
+    depend on the scale of the bins. While the largest bin grows by less
+    than half a pixel of the strip, only the bar of the value is redrawn.
+    All bars are redrawn once it grew further, which happens a bounded
+    number of times per half-life, so a sample costs O(1) amortized.
+
+    The bins are spread over the range like the pixels in valueToPixel(),
+    so the first bin is centered on the minimum and the last on the maximum.
+    The sample goes to the bin drawn at the line of the value.
+*/
+void QtMultiSlider::addHistogramSample(int value)
+{
+    const double range = double(m_maximum) - m_minimum;
+    const int bins = m_histogram.size();
+    int bin = range > 0 ? qRound((double(value) - m_minimum) / range * (bins - 1)) : 0;
+
+    const int span = m_layout.histogram.height() - 1;
+    if (span > 0) {
+        const int pixel = valueToPixel(value);
+        int low, high;
+        histogramBinPixels(bin, bins, span, &low, &high);
+        while (pixel < low)
+            histogramBinPixels(--bin, bins, span, &low, &high);
+        while (pixel > high)
+            histogramBinPixels(++bin, bins, span, &low, &high);
     }
+
+    m_histogram[bin] += m_histogramIncrement;
+    m_histogramIncrement *= m_histogramGrowth;
+    m_histogramMaximum = qMax(m_histogramMaximum, m_histogram.at(bin));
+
+    // the ratios and so the display stay the same
+    const qreal scale = qreal(1) / (qint64(1) << 32);
+    if (m_histogramIncrement > 1 / scale) {
+        for (int i = 0; i < m_histogram.size(); ++i)
+            m_histogram[i] *= scale;
+        m_histogramIncrement *= scale;
+        m_histogramMaximum *= scale;
+        m_histogramReference *= scale;
+    }
+
+    const int width = m_histogramStrip.width();
+    if (m_histogramMaximum > m_histogramReference * (1 + qreal(0.5) / qMax(width, 1))) {
+        m_histogramReference = m_histogramMaximum;
+        for (int i = 0; i < m_histogram.size(); ++i)
+            updateHistogramBin(i);
+    } else {
+        updateHistogramBin(bin);
+    }
+}
+
+/*!
+    Returns the actual value.
+*/
+int QtMultiSlider::value() const
+{
+    return m_value;
+}
+
+/*!
+    Returns the minimum of the value bar.
+*/
+int QtMultiSlider::minimum() const
+{
+    return m_minimum;
+}
+
+/*!
+    Returns the maximum of the value bar.
+*/
+int QtMultiSlider::maximum() const
+{
+    return m_maximum;
+}
+
+/*!
+    Set the minimum of the value bar. If it is above the maximum, the
+    maximum is set to it as well.
+*/
+void QtMultiSlider::setMinimum(int minimum)
+{
+    setRange(minimum, qMax(minimum, m_maximum));
+}
+
+/*!
+    Set the maximum of the value bar. If it is below the minimum, the
+    minimum is set to it as well.
+*/
+void QtMultiSlider::setMaximum(int maximum)
+{
+    setRange(qMin(m_minimum, maximum), maximum);
+}
+
+/*!
+    Set the actual vlaue. Values outside of the range are bound to it, so a
+    level above the maximum shows a full bar.
+*/
+void QtMultiSlider::setValue(int value)
+{
+    value = qBound(m_minimum, value, m_maximum);
+
+    // the histogram counts the time at a level, so it takes every sample
+    if (m_histogramEnabled)
+        addHistogramSample(value);
+
+    if (value == m_value)
+        return;
+
+    const int previous = m_value;
+    m_value = value;
+    updateValueLayout();
+    emit valueChanged(value);
+
+    // with hysteresis the states of the thresholds up to the band beyond
+    // the old and the new value can change
+    checkThresholds(qMin(previous, value) - m_hysteresis, qMax(previous, value) + m_hysteresis);
+    checkRangeExceeded();
 }
 
 /*!
-    Check if the bottom slider value is smaller than the actual value.
-    If true send the signal minimumExceeded(bool).
+    Set the range of the value bar. If \a maximum is below \a minimum, the
+    range only holds \a minimum. The value and thresholds outside of the new
+    range are moved to its bounds.
 */
-void QtMultiSlider::checkMinimumRange(int bottomSliderValue)
+void QtMultiSlider::setRange(int minimum, int maximum)
 {
-    const bool exceeded = value() < bottomSliderValue;
-    if (m_previousExceededMinimum != exceeded) {
-        m_previousExceededMinimum = exceeded;
-        emit minimumExceeded(exceeded);
+    if (minimum == m_minimum && qMax(minimum, maximum) == m_maximum)
+        return;
+
+    m_minimum = minimum;
+    m_maximum = qMax(minimum, maximum);
+
+    const int value = qBound(m_minimum, m_value, m_maximum);
+    if (value != m_value) {
+        m_value = value;
+        emit valueChanged(value);
+    }
+
+    for (int i = 0; i < m_handles.size(); ++i) {
+        const int value = qBound(this->minimum(), m_handles.at(i).value, this->maximum());
+        if (value != m_handles.at(i).value) {
+            m_handles[i].value = value;
+            emit thresholdChanged(i, value);
+        }
     }
+
+    updateValueLayout();
+    for (int i = 0; i < m_handles.size(); ++i)
+        updateThresholdLayout(i);
+
+    checkThresholds(this->minimum(), this->maximum());
+    checkRangeExceeded();
+
+    updateHelpers();
+
+    // the bins cover the old range
+    clearHistogram();
 }
 
 /*!
-    Set the maximum range of the topSlider.
+    Moves the threshold at \a index to \a value. The value is bound to the
+    range and to the values of the neighbouring thresholds.
 */
-void QtMultiSlider::setMaximumRange(int maximum)
+void QtMultiSlider::setThresholdValue(int index, int value)
 {
-    topSlider()->setValue(maximum);
+    if (index < 0 || index >= m_handles.size())
+        return;
+
+    const int low = index > 0 ? m_handles.at(index - 1).value : minimum();
+    const int high = index < m_handles.size() - 1 ? m_handles.at(index + 1).value : maximum();
+    value = qBound(low, value, high);
+    if (value == m_handles.at(index).value)
+        return;
+
+    m_handles[index].value = value;
+    updateThresholdLayout(index);
+    emit thresholdChanged(index, value);
+    updateHelpers();
+
+    checkThreshold(index);
+    checkRangeExceeded();
 }
 
 /*!
-    Set the minimum range of the bottomSlider.
+    \internal
+    Checks the thresholds with values from \a from to \a to, the only ones
+    whose state can change if the value moves between them.
 */
-void QtMultiSlider::setMinimumRange(int minimum)
+void QtMultiSlider::checkThresholds(int from, int to)
 {
-    bottomSlider()->setValue(minimum);
+    int i = std::lower_bound(m_handles.constBegin(), m_handles.constEnd(), from,
+                             [](const Handle &handle, int value) { return handle.value < value; })
+            - m_handles.constBegin();
+    for (; i < m_handles.size() && m_handles.at(i).value <= to; ++i)
+        checkThreshold(i);
 }
 
 /*!
-    \overload
     \internal
-    Overloaded paint event that draws all elmements with the
-    SVG graphics.
+    Checks the threshold at \a index depending on its type.
 */
-void QtMultiSlider::paintEvent(QPaintEvent * event)
+void QtMultiSlider::checkThreshold(int index)
 {
-    Q_UNUSED(event)
+    if (m_handles.at(index).type == UpperLimit)
+        checkMaximumRange(index);
+    else
+        checkMinimumRange(index);
+}
 
-    if (!isVisible())
+/*!
+    Check if the value is bigger than the upper limit at \a index. Once
+    exceeded, the value has to fall below the hysteresis band to clear it.
+*/
+void QtMultiSlider::checkMaximumRange(int index)
+{
+    const Handle &handle = m_handles.at(index);
+    const int limit = handle.exceeded ? handle.value - m_hysteresis : handle.value;
+    setThresholdExceeded(index, value() > limit);
+}
+
+/*!
+    Check if the value is smaller than the lower limit at \a index. Once
+    exceeded, the value has to rise above the hysteresis band to clear it.
+*/
+void QtMultiSlider::checkMinimumRange(int index)
+{
+    const Handle &handle = m_handles.at(index);
+    const int limit = handle.exceeded ? handle.value + m_hysteresis : handle.value;
+    setThresholdExceeded(index, value() < limit);
+}
+
+/*!
+    \internal
+    Sets the state of the threshold at \a index and sends the signal
+    thresholdExceeded(int, bool) if it changed. Within the hold time of the
+    last change the new state is only marked pending, it is checked again
+    when the hold time is over.
+*/
+void QtMultiSlider::setThresholdExceeded(int index, bool exceeded)
+{
+    Handle &handle = m_handles[index];
+    handle.pending = false;
+    if (handle.exceeded == exceeded)
         return;
 
-    QPainter painter;
-    painter.begin(this);
+    const qint64 now = m_clock.elapsed();
+    if (now < handle.heldUntil) {
+        handle.pending = true;
+        if (!m_holdTimer.isActive() || handle.heldUntil < m_holdDeadline) {
+            m_holdDeadline = handle.heldUntil;
+            m_holdTimer.start(int(handle.heldUntil - now), this);
+        }
+        return;
+    }
+
+    handle.exceeded = exceeded;
+    handle.heldUntil = now + m_holdTime;
+    emit thresholdExceeded(index, exceeded);
+}
+
+/*!
+    \internal
+    Sends maximumExceeded(bool) and minimumExceeded(bool) if the state of
+    the lowest upper or the highest lower limit changed.
+*/
+void QtMultiSlider::checkRangeExceeded()
+{
+    const bool exceededMaximum = m_maximumIndex >= 0 && m_handles.at(m_maximumIndex).exceeded;
+    if (m_previousExceededMaximum != exceededMaximum) {
+        m_previousExceededMaximum = exceededMaximum;
+        emit maximumExceeded(exceededMaximum);
+    }
+
+    const bool exceededMinimum = m_minimumIndex >= 0 && m_handles.at(m_minimumIndex).exceeded;
+    if (m_previousExceededMinimum != exceededMinimum) {
+        m_previousExceededMinimum = exceededMinimum;
+        emit minimumExceeded(exceededMinimum);
+    }
+}
+
+/*!
+    \internal
+    Finds the lowest upper and the highest lower limit after a threshold was
+    added or removed. Moving a threshold cannot change them, since the
+    thresholds keep their order.
+*/
+void QtMultiSlider::updateRangeIndexes()
+{
+    m_maximumIndex = -1;
+    for (int i = 0; i < m_handles.size() && m_maximumIndex < 0; ++i) {
+        if (m_handles.at(i).type == UpperLimit)
+            m_maximumIndex = i;
+    }
 
-    // Calculating the layout:
-    int spacing = 5;
-    int labelHeight = 0;
+    m_minimumIndex = -1;
+    for (int i = m_handles.size() - 1; i >= 0 && m_minimumIndex < 0; --i) {
+        if (m_handles.at(i).type == LowerLimit)
+            m_minimumIndex = i;
+    }
 
-    int valueBarWidth = 20;
+    updateHelpers();
+}
 
-    // Calculating the maximum string size
+/*!
+    Set the lowest upper limit.
+*/
+void QtMultiSlider::setMaximumRange(int maximum)
+{
+    setThresholdValue(m_maximumIndex, maximum);
+}
 
-    int valueBarX = spacing;
+/*!
+    Set the highest lower limit.
+*/
+void QtMultiSlider::setMinimumRange(int minimum)
+{
+    setThresholdValue(m_minimumIndex, minimum);
+}
+
+/*!
+    \internal
+    Calculates the layout of the value bar, the groove and the size of the
+    slider handles. Called when the size or the skin changes.
+*/
+void QtMultiSlider::updateLayout()
+{
+    const int spacing = 5;
+    const int labelHeight = 0;
+    const int valueBarWidth = 20;
+    const int valueBarX = spacing;
 
     int valueBarTopY = 0;
     int valueBarBottomY = 0;
 
-    QSizeF originalSize = m_rendererValueBarTop->defaultSize();
+    const QSizeF originalSize = m_rendererValueBarTop->defaultSize();
     QSizeF targetSize = originalSize;
     targetSize.scale(QSizeF(valueBarWidth, originalSize.height()), Qt::KeepAspectRatio);
-    qreal scaleRatio = targetSize.width() /
-                       originalSize.width();
+    const qreal scaleRatio = originalSize.width() > 0 ? targetSize.width() / originalSize.width() : 0;
 
-    QSize topSliderHandleSize = m_topSliderRenderer->defaultSize() * scaleRatio;
-    QSize bottomSliderHandleSize = m_bottomSliderRenderer->defaultSize() * scaleRatio;
+    // the hovered and pressed handles have the same size
+    m_layout.topSliderSize = m_rendererTopSlider->defaultSize() * scaleRatio;
+    m_layout.bottomSliderSize = m_rendererBottomSlider->defaultSize() * scaleRatio;
 
-    QSize valueBarTopSize = m_rendererValueBarTop->defaultSize() * scaleRatio;
+    const QSize valueBarTopSize = m_rendererValueBarTop->defaultSize() * scaleRatio;
+    if (m_layout.topSliderSize.height() > valueBarTopSize.height())
+        valueBarTopY = m_layout.topSliderSize.height() - valueBarTopSize.height();
 
+    m_layout.valueBarTop = QRect(QPoint(valueBarX, valueBarTopY), valueBarTopSize);
 
-    if (topSliderHandleSize.height() > valueBarTopSize.height())
-    {
-        valueBarTopY =topSliderHandleSize.height() - valueBarTopSize.height();
+    const QSize valueBarBottomSize = m_rendererValueBarBottom->defaultSize() * scaleRatio;
+    if (m_layout.bottomSliderSize.height() > valueBarBottomSize.height()) {
+        valueBarBottomY = height() - labelHeight - m_layout.valueBarTop.bottom()
+                          - m_layout.bottomSliderSize.height();
+    } else {
+        valueBarBottomY = height() - labelHeight - m_layout.valueBarTop.bottom()
+                          - valueBarBottomSize.height();
     }
 
+    m_layout.valueBar = QRect(QPoint(valueBarX, m_layout.valueBarTop.bottom()),
+                              QSize(valueBarWidth, valueBarBottomY));
+    m_layout.valueBarBottom = QRect(QPoint(valueBarX, m_layout.valueBar.bottom()), valueBarBottomSize);
 
-    QRect valueBarTopRect = QRect(QPoint(valueBarX, valueBarTopY),
-                                  valueBarTopSize);
-    m_rendererValueBarTop->render(&painter, valueBarTopRect);
+    // the background of the sliders
+    const int w = m_layout.topSliderSize.width() - 20;
+    const int h = m_layout.valueBar.bottom();
+    m_layout.groove = QRect(m_layout.valueBar.right() + 2 + 15, valueBarTopY, w - 5, h);
 
-    QSize valueBarBottomSize = m_rendererValueBarBottom->defaultSize() * scaleRatio;
+    // the histogram is drawn in the groove, level with the value bar
+    m_layout.histogram = QRect(m_layout.groove.left(), m_layout.valueBar.top(),
+                               m_layout.groove.width(), m_layout.valueBar.height());
 
-    if (bottomSliderHandleSize.height() > valueBarBottomSize.height()) {
-        valueBarBottomY = height() - labelHeight - valueBarTopRect.bottom()
-                            - bottomSliderHandleSize.height();
-    } else {
-        valueBarBottomY = height() - labelHeight - valueBarTopRect.bottom()
-                            - valueBarBottomSize.height();
+    updateValueLayout();
+    updateHistogramStrip();
+    for (int i = 0; i < m_handles.size(); ++i)
+        updateThresholdLayout(i);
+    update();
+}
+
+/*!
+    \internal
+    Calculates the filled part of the value bar. Called when the size, the
+    skin, the range or the value changes. Only the band of the value bar
+    between the old and the new value is repainted.
+*/
+void QtMultiSlider::updateValueLayout()
+{
+    const QRect previousFilled = m_layout.filled;
+
+    // the same mapping as the handles, so the fill meets a threshold line
+    // exactly when the value reaches it
+    const int filledPixels = valueToPixel(value());
+    m_layout.filled = m_layout.valueBar;
+    m_layout.filled.setTop(m_layout.filled.bottom() - filledPixels);
+
+    if (m_layout.filled != previousFilled) {
+        const int top = qMin(m_layout.filled.top(), previousFilled.top());
+        const int bottom = qMax(m_layout.filled.top(), previousFilled.top());
+        update(QRect(m_layout.valueBar.left(), top - 1, m_layout.valueBar.width(), bottom - top + 2));
     }
+}
 
-    m_valueBarRect =    QRect(QPoint(valueBarX, valueBarTopRect.bottom()),
-                              QSize(valueBarWidth, valueBarBottomY));
+/*!
+    \internal
+    Draws all bins of the histogram into a new strip for the current size.
+*/
+void QtMultiSlider::updateHistogramStrip()
+{
+    m_histogramLengths.fill(0, m_histogram.size());
+    m_histogramReference = m_histogramMaximum;
+    if (m_histogram.isEmpty() || m_layout.histogram.isEmpty()) {
+        m_histogramStrip = QImage();
+        return;
+    }
 
-    m_rendererValueBar->render(&painter, m_valueBarRect);
+    m_histogramStrip = QImage(m_layout.histogram.size(), QImage::Format_ARGB32_Premultiplied);
+    m_histogramStrip.fill(0);
+    for (int i = 0; i < m_histogram.size(); ++i)
+        updateHistogramBin(i);
+}
 
-    QRect valueBarBottomRect = QRect(QPoint(valueBarX, m_valueBarRect.bottom()),
-                                     valueBarBottomSize);
-    m_rendererValueBarBottom->render(&painter, valueBarBottomRect);
+/*!
+    \internal
+    Draws the bar of \a bin into the strip and repaints its rows if its
+    length in pixels changed. The bar is drawn relative to the largest bin
+    at the last full redraw, so it may reach past the largest bin by less
+    than half a pixel, which is cut off.
+*/
+void QtMultiSlider::updateHistogramBin(int bin)
+{
+    if (m_histogramStrip.isNull())
+        return;
 
+    const int width = m_histogramStrip.width();
+    const qreal reference = m_histogramReference;
+    const int length = reference > 0 ? qMin(width, qRound(m_histogram.at(bin) / reference * width)) : 0;
+    if (length == m_histogramLengths.at(bin))
+        return;
+    m_histogramLengths[bin] = length;
+
+    QColor color = palette().color(QPalette::Highlight);
+    color.setAlpha(96);
+    const QRgb pixel = qPremultiply(color.rgba());
+
+    // the lowest bin is at the bottom of the strip, every bin is centered
+    // on the line of its value and reaches half way to its neighbours
+    const int span = m_histogramStrip.height() - 1;
+    int low, high;
+    histogramBinPixels(bin, m_histogram.size(), span, &low, &high);
+    const int top = span - high;
+    const int bottom = span - low + 1;
+    for (int y = top; y < bottom; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(m_histogramStrip.scanLine(y));
+        std::fill(line, line + length, pixel);
+        std::fill(line + length, line + width, 0);
+    }
 
-    // Drawing the actual value bar
-    int filledPixels = ((double)value()) / maximum() * m_valueBarRect.height();
-    QRect filledRect = m_valueBarRect;
-    filledRect.setTop(filledRect.bottom() - filledPixels);
-    m_rendererValueBarFilled->render(&painter, filledRect);
+    update(QRect(m_layout.histogram.left(), m_layout.histogram.top() + top, width, bottom - top));
+}
 
-    // draw the background of the sliders
-    int w = topSliderHandleSize.width() - 20;
-    int h = m_valueBarRect.bottom();
-    QRect rect(m_valueBarRect.right() + 2 + 15, valueBarTopY, w - 5, h);
-    m_rendererGroove->render(&painter, rect);
+/*!
+    \internal
+    Moves the handle of the threshold at \a index to its value and repaints
+    its old and new rectangle.
+*/
+void QtMultiSlider::updateThresholdLayout(int index)
+{
+    Handle &handle = m_handles[index];
+    const QRect previous = handle.rect;
+
+    const int sliderSpacing = 2;
+    handle.line = m_layout.valueBar.bottom() - valueToPixel(handle.value);
+    if (handle.type == UpperLimit) {
+        handle.rect = QRect(QPoint(m_layout.valueBar.right() + sliderSpacing,
+                                   handle.line - m_layout.topSliderSize.height()),
+                            m_layout.topSliderSize);
+    } else {
+        handle.rect = QRect(QPoint(m_layout.valueBar.right() + sliderSpacing, handle.line),
+                            m_layout.bottomSliderSize);
+    }
 
-    // Drawing the min-max sliders
-    int sliderSpacing = 2;
-    m_topSlider->setGeometry(QRect(
-                                 QPoint(m_valueBarRect.right() + sliderSpacing,
-                                        m_valueBarRect.bottom() - valueToPixel(topSlider()->value()) - topSliderHandleSize.height()),
-                                 topSliderHandleSize
-                             ));
+    if (handle.rect != previous)
+        update(handle.rect | previous);
+}
 
-    m_topSliderRenderer->render(&painter, m_topSlider->geometry());
+/*!
+    \overload
+    \internal
+    Overloaded paint event that draws all elmements with the
+    SVG graphics at the positions of the cached layout.
+*/
+void QtMultiSlider::paintEvent(QPaintEvent * event)
+{
+    if (!isVisible())
+        return;
+
+    QPainter painter;
+    painter.begin(this);
 
-    m_bottomSlider->setGeometry(QRect(
-                                    QPoint(m_valueBarRect.right() + sliderSpacing,
-                                           m_valueBarRect.bottom() - valueToPixel(bottomSlider()->value())),
-                                    bottomSliderHandleSize
-                                ));
+    // a value update only repaints a band of the bar and the handles
+    const QRect dirty = event->rect();
+
+    if (dirty.intersects(m_layout.valueBarTop))
+        m_rendererValueBarTop->render(&painter, m_layout.valueBarTop);
+    if (dirty.intersects(m_layout.valueBar))
+        m_rendererValueBar->render(&painter, m_layout.valueBar);
+    if (dirty.intersects(m_layout.valueBarBottom))
+        m_rendererValueBarBottom->render(&painter, m_layout.valueBarBottom);
+
+    // Drawing the actual value bar: the filled bar is rasterized once in
+    // the size of the whole bar and only the filled part is revealed, so a
+    // new value does not render the SVG again
+    if (dirty.intersects(m_layout.filled)) {
+        painter.save();
+        painter.setClipRect(m_layout.filled);
+        m_rendererValueBarFilled->render(&painter, m_layout.valueBar);
+        painter.restore();
+    }
+
+    // draw the background of the sliders
+    if (dirty.intersects(m_layout.groove))
+        m_rendererGroove->render(&painter, m_layout.groove);
+
+    // the histogram only copies the exposed part of its strip
+    if (!m_histogramStrip.isNull() && dirty.intersects(m_layout.histogram)) {
+        const QRect exposed = dirty & m_layout.histogram;
+        painter.drawImage(exposed, m_histogramStrip, exposed.translated(-m_layout.histogram.topLeft()));
+    }
 
-    m_bottomSliderRenderer->render(&painter, m_bottomSlider->geometry());
+    // Drawing the threshold sliders in the exposed rows, all handles of a
+    // type and state share one cached pixmap
+    const int lowest = dirty.top() - m_layout.bottomSliderSize.height();
+    for (int i = firstThresholdBelow(dirty.bottom()); i < m_handles.size() && m_handles.at(i).line > lowest; ++i) {
+        const Handle &handle = m_handles.at(i);
+        if (!dirty.intersects(handle.rect))
+            continue;
+
+        QtSvgPixmapCache *renderer;
+        if (handle.type == UpperLimit) {
+            renderer = i == m_pressed ? m_rendererTopSliderPressed
+                       : i == m_hovered ? m_rendererTopSliderHovered : m_rendererTopSlider;
+        } else {
+            renderer = i == m_pressed ? m_rendererBottomSliderPressed
+                       : i == m_hovered ? m_rendererBottomSliderHovered : m_rendererBottomSlider;
+        }
+        renderer->render(&painter, handle.rect);
+    }
 
     painter.end();
 }
 
 /*!
+    \overload
+    \internal
+    Calculates the layout for the new size.
+*/
+void QtMultiSlider::resizeEvent(QResizeEvent * event)
+{
+    QWidget::resizeEvent(event);
+    updateLayout();
+}
+
+/*!
+    \overload
     \internal
-    This function calculates from the actual value the pixel in the progress bar.
+    Checks the thresholds whose hold time is over.
+*/
+void QtMultiSlider::timerEvent(QTimerEvent * event)
+{
+    if (event->timerId() != m_holdTimer.timerId()) {
+        QWidget::timerEvent(event);
+        return;
+    }
+
+    // thresholds still held schedule the timer again
+    m_holdTimer.stop();
+    for (int i = 0; i < m_handles.size(); ++i) {
+        if (m_handles.at(i).pending)
+            checkThreshold(i);
+    }
+    checkRangeExceeded();
+}
+
+/*!
+    \internal
+    This function calculates from the actual value the pixel in the value bar,
+    counted from its bottom. An empty range maps every value to the bottom.
 */
 int  QtMultiSlider::valueToPixel(int value)
 {
-    return (double)(value) / (double)(maximum() - minimum())
-           * (double)(m_valueBarRect.bottom() - m_valueBarRect.top());
+    const double range = double(maximum()) - minimum();
+    if (range <= 0)
+        return 0;
+
+    return qRound((double(value) - minimum()) / range
+                  * (m_layout.valueBar.bottom() - m_layout.valueBar.top()));
 }
 
 /*!
     \internal
-    This function calculates from the actual pixel the set value from the progress bar.
+    This function calculates from the actual pixel the set value from the value bar.
 */
 int  QtMultiSlider::pixelToValue(int pixel)
 {
-    if (pixel < 0)
+    const int height = m_layout.valueBar.bottom() - m_layout.valueBar.top();
+    if (pixel <= 0 || height <= 0)
         return minimum();
-    if (pixel > m_valueBarRect.bottom())
+    if (pixel >= height)
         return maximum();
 
-    return (double)(pixel) / (double)(m_valueBarRect.bottom() - m_valueBarRect.top())
-           * (double)(maximum() - minimum());
+    return minimum() + qRound(double(pixel) / height * (double(maximum()) - minimum()));
 }
 
 /*!
@@ -424,7 +1237,24 @@ void QtMultiSlider::leaveEvent(QEvent * event)
 {
     Q_UNUSED(event)
 
-    update();
+    // only the handles show the hover state
+    if (m_hovered >= 0) {
+        update(m_handles.at(m_hovered).rect);
+        m_hovered = -1;
+    }
+}
+
+/*!
+    \internal
+    \overload
+    Redraws the histogram in the new highlight color if the palette changes.
+*/
+void QtMultiSlider::changeEvent(QEvent * event)
+{
+    if (event->type() == QEvent::PaletteChange)
+        updateHistogramStrip();
+
+    QWidget::changeEvent(event);
 }
 
 /*!
@@ -434,14 +1264,8 @@ void QtMultiSlider::leaveEvent(QEvent * event)
 */
 void QtMultiSlider::mouseMoveEvent(QMouseEvent * event)
 {
-    if (m_topSlider->isSliderDown()) {
-        m_topSlider->setValue(pixelToValue(m_valueBarRect.bottom() - (event->y() - (m_dragStartPosition.y() - (m_valueBarRect.bottom() - valueToPixel(m_dragStartValue))))));
-        m_bottomSlider->setMaximum(m_topSlider->value());
-    }
-
-    if (m_bottomSlider->isSliderDown()) {
-        m_bottomSlider->setValue(pixelToValue(m_valueBarRect.bottom() - (event->y() - (m_dragStartPosition.y() - (m_valueBarRect.bottom() - valueToPixel(m_dragStartValue))))));
-        m_topSlider->setMinimum(m_bottomSlider->value());
+    if (m_pressed >= 0) {
+        setThresholdValue(m_pressed, pixelToValue(m_layout.valueBar.bottom() - (event->y() - (m_dragStartPosition.y() - (m_layout.valueBar.bottom() - valueToPixel(m_dragStartValue))))));
     }
 
     updateSliders(event);
@@ -454,20 +1278,13 @@ void QtMultiSlider::mouseMoveEvent(QMouseEvent * event)
 */
 void QtMultiSlider::mousePressEvent(QMouseEvent * event)
 {
-    if (event->button() == Qt::LeftButton &&
-            (m_topSlider->geometry().contains(event->pos()) || m_bottomSlider->geometry().contains(event->pos()))) {
+    const int index = event->button() == Qt::LeftButton ? thresholdAt(event->pos()) : -1;
+    if (index >= 0) {
         m_dragInProgress = true;
         m_dragStartPosition = event->pos();
-
-        if (m_topSlider->geometry().contains(event->pos())) {
-            m_topSlider->setSliderDown(true);
-            m_dragStartValue = m_topSlider->value();
-        }
-
-        if (m_bottomSlider->geometry().contains(event->pos())) {
-            m_bottomSlider->setSliderDown(true);
-            m_dragStartValue = m_bottomSlider->value();
-        }
+        m_dragStartValue = m_handles.at(index).value;
+        m_pressed = index;
+        update(m_handles.at(index).rect);
 
         updateSliders(event);
     }
@@ -482,8 +1299,10 @@ void QtMultiSlider::mouseReleaseEvent(QMouseEvent * event)
 {
     m_dragInProgress = false;
 
-    m_topSlider->setSliderDown(false);
-    m_bottomSlider->setSliderDown(false);
+    if (m_pressed >= 0) {
+        update(m_handles.at(m_pressed).rect);
+        m_pressed = -1;
+    }
 
     updateSliders(event);
 }
@@ -491,38 +1310,18 @@ void QtMultiSlider::mouseReleaseEvent(QMouseEvent * event)
 /*!
     \internal
     \overload
-    Update slider picture.
+    Update the hovered slider picture.
 */
 void QtMultiSlider::updateSliders(QMouseEvent * event)
 {
-    QPointer<QtSvgPixmapCache> previousTopSliderRenderer = m_topSliderRenderer;
-    QPointer<QtSvgPixmapCache> previousBottomSliderRenderer = m_bottomSliderRenderer;
-
-    //update renderer depending on slider state
-    m_topSliderRenderer = m_rendererTopSlider;
-    if (m_topSlider->geometry().contains(event->pos())) {
-        if (m_topSlider->isSliderDown()) {
-            m_topSliderRenderer = m_rendererTopSliderPressed;
-        }
-        else {
-            m_topSliderRenderer = m_rendererTopSliderHovered;
-        }
-    }
-
-    //update renderer depending on slider state
-    m_bottomSliderRenderer = m_rendererBottomSlider;
-    if (m_bottomSlider->geometry().contains(event->pos())) {
-        if (m_bottomSlider->isSliderDown()) {
-            m_bottomSliderRenderer = m_rendererBottomSliderPressed;
-        }
-        else {
-            m_bottomSliderRenderer = m_rendererBottomSliderHovered;
-        }
-    }
+    const int previous = m_hovered;
+    m_hovered = thresholdAt(event->pos());
 
     //repaint sliders on renderer change
-    if (previousTopSliderRenderer != m_topSliderRenderer ||
-            previousBottomSliderRenderer != m_bottomSliderRenderer) {
-        update();
+    if (previous != m_hovered) {
+        if (previous >= 0)
+            update(m_handles.at(previous).rect);
+        if (m_hovered >= 0)
+            update(m_handles.at(m_hovered).rect);
     }
 }
@@ -9,12 +9,15 @@
 #ifndef QT_MULTI_SLIDER_H
 #define QT_MULTI_SLIDER_H
 
+#include <QAbstractSlider>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QImage>
 #include <QPointer>
 #include <QString>
 #include <QRect>
-#include <QSharedData>
-#include <QAbstractSlider>
-#include <QProgressBar>
+#include <QVector>
+#include <QWidget>
 
 #include "qtsvgpixmapcache.h"
 
@@ -30,32 +33,82 @@ private:
     void paintEvent(QPaintEvent * event);
 };
 
-class QtMultiSlider : public QProgressBar
+class QtMultiSlider : public QWidget
 {
     Q_OBJECT
     Q_PROPERTY(QString skin READ skin WRITE setSkin)
+    Q_PROPERTY(int value READ value WRITE setValue NOTIFY valueChanged)
+    Q_PROPERTY(int minimum READ minimum WRITE setMinimum)
+    Q_PROPERTY(int maximum READ maximum WRITE setMaximum)
+    Q_PROPERTY(int hysteresis READ hysteresis WRITE setHysteresis)
+    Q_PROPERTY(int holdTime READ holdTime WRITE setHoldTime)
+    Q_PROPERTY(bool histogramEnabled READ isHistogramEnabled WRITE setHistogramEnabled)
+    Q_PROPERTY(int histogramHalfLife READ histogramHalfLife WRITE setHistogramHalfLife)
+    Q_ENUMS(ThresholdType)
 public:
+    enum ThresholdType {
+        LowerLimit,
+        UpperLimit
+    };
+
     QtMultiSlider(QWidget * parent = 0);
     virtual ~QtMultiSlider();
 
-    QtMultiSliderHelper * topSlider();
-    QtMultiSliderHelper * bottomSlider();
+    // the upper and lower slider are thresholds now, see maximumRange()
+    // and minimumRange()
+    QT_DEPRECATED QtMultiSliderHelper * topSlider();
+    QT_DEPRECATED QtMultiSliderHelper * bottomSlider();
 
     void setSkin(const QString& skin);
     QString skin() const;
+
+    int value() const;
+    int minimum() const;
+    int maximum() const;
+
+    void setMinimum(int minimum);
+    void setMaximum(int maximum);
+
+    int addThreshold(int value, ThresholdType type);
+    void removeThreshold(int index);
+    void clearThresholds();
+    int thresholdCount() const;
+
+    int thresholdValue(int index) const;
+    ThresholdType thresholdType(int index) const;
+    bool isThresholdExceeded(int index) const;
+    int thresholdAt(const QPoint &pos) const;
+
+    int maximumRange() const;
+    int minimumRange() const;
+
+    void setHysteresis(int hysteresis);
+    int hysteresis() const;
+
+    void setHoldTime(int msecs);
+    int holdTime() const;
+
+    void setHistogramEnabled(bool enabled);
+    bool isHistogramEnabled() const;
+
+    void setHistogramHalfLife(int samples);
+    int histogramHalfLife() const;
+
+    void clearHistogram();
+
 public Q_SLOTS:
 
+    void setThresholdValue(int index, int value);
     void setMaximumRange(int maximum);
     void setMinimumRange(int minimum);
     void setValue(int);
-
-private Q_SLOTS:
-
-    void checkMinimumRange(int value);
-    void checkMaximumRange(int value);
+    void setRange(int minimum, int maximum);
 
 Q_SIGNALS:
 
+    void valueChanged(int value);
+    void thresholdChanged(int index, int value);
+    void thresholdExceeded(int index, bool exceeded);
     void maximumExceeded(bool exceeded);
     void minimumExceeded(bool exceeded);
 
@@ -65,6 +118,8 @@ private:
     QtSvgPixmapCache *m_rendererValueBarTop;
     QtSvgPixmapCache *m_rendererValueBarBottom;
 
+    // one cache per handle type and state, shared by all handles of that
+    // type since they have the same size
     QtSvgPixmapCache *m_rendererTopSlider;
     QtSvgPixmapCache *m_rendererTopSliderHovered;
     QtSvgPixmapCache *m_rendererTopSliderPressed;
@@ -75,20 +130,104 @@ private:
 
     QtSvgPixmapCache *m_rendererGroove;
 
-    QRect m_valueBarRect;
-
+    // geometry of all parts, computed when the size, the skin or a value
+    // changes, so paintEvent() only draws
+    struct Layout {
+        QRect valueBarTop;
+        QRect valueBar;
+        QRect valueBarBottom;
+        QRect filled;
+        QRect groove;
+        QRect histogram;
+        QSize topSliderSize;
+        QSize bottomSliderSize;
+    };
+
+    Layout m_layout;
+
+    // the value model, the value is always within the range
+    int m_minimum;
+    int m_maximum;
+    int m_value;
+
+    enum {
+        MaxHistogramBins = 128
+    };
+
+    // time the value spent in each bin, decaying per sample. The bins are
+    // kept relative to a growing increment instead of decaying them all,
+    // and are scaled down together once the increment gets large. The bars
+    // are drawn relative to the largest bin, m_histogramReference is the
+    // largest bin the strip was drawn for.
+    bool m_histogramEnabled;
+    int m_histogramHalfLife;
+    qreal m_histogramGrowth;
+    qreal m_histogramIncrement;
+    qreal m_histogramMaximum;
+    qreal m_histogramReference;
+    QVector<qreal> m_histogram;
+    QVector<int> m_histogramLengths;
+    QImage m_histogramStrip;
+
+    // a threshold handle; an upper limit is drawn above its line, a lower
+    // limit below it. The exceeded state cannot change before heldUntil,
+    // a change that has to wait for it is pending.
+    struct Handle {
+        int value;
+        ThresholdType type;
+        bool exceeded;
+        bool pending;
+        qint64 heldUntil;
+        QRect rect;
+        int line;
+    };
+
+    // sorted by value, so the lines are sorted in descending order
+    QVector<Handle> m_handles;
+
+    // the lowest upper and the highest lower limit, reported with
+    // maximumExceeded() and minimumExceeded()
+    int m_maximumIndex;
+    int m_minimumIndex;
     bool m_previousExceededMaximum;
     bool m_previousExceededMinimum;
 
+    int m_hysteresis;
+    int m_holdTime;
+    QElapsedTimer m_clock;
+    QBasicTimer m_holdTimer;
+    qint64 m_holdDeadline;
+
+    int m_hovered;
+    int m_pressed;
+
+    // created on demand by the deprecated topSlider() and bottomSlider()
     QPointer<QtMultiSliderHelper> m_topSlider;
     QPointer<QtMultiSliderHelper> m_bottomSlider;
 
-    QPointer<QtSvgPixmapCache> m_topSliderRenderer;
-    QPointer<QtSvgPixmapCache> m_bottomSliderRenderer;
-
     void init();
+    QtMultiSliderHelper * createHelper(int value, const char *slot);
+    void updateHelpers();
+    void updateLayout();
+    void updateValueLayout();
+    void updateHistogramStrip();
+    void updateHistogramBin(int bin);
+    void addHistogramSample(int value);
+    void updateThresholdLayout(int index);
+    void updateRangeIndexes();
+
+    int firstThresholdBelow(int y) const;
+
+    void checkThresholds(int from, int to);
+    void checkThreshold(int index);
+    void checkMaximumRange(int index);
+    void checkMinimumRange(int index);
+    void checkRangeExceeded();
+    void setThresholdExceeded(int index, bool exceeded);
 
     void paintEvent(QPaintEvent * event);
+    void resizeEvent(QResizeEvent * event);
+    void timerEvent(QTimerEvent * event);
 
     void updateSliders(QMouseEvent * event);
 
@@ -108,6 +247,7 @@ private:
     bool m_dragInProgress;
 
     void leaveEvent(QEvent * event);
+    void changeEvent(QEvent * event);
 
     QString m_skin;
 };
@@ -14,6 +14,25 @@
 #include <QSvgRenderer>
 #include <QMouseEvent>
 #include <QApplication>
+#include <QScreen>
+#include <QWindow>
+#include <qmath.h>
+
+// speed of the pointer in pixels per millisecond above which a drag moves
+// more steps per pixel, up to MaxAcceleration times as many
+static const qreal AccelerationSpeed = 0.5;
+static const qreal MaxAcceleration = 40;
+
+// time constant of the deceleration of a flicked wheel in seconds, the
+// wheel travels its initial velocity times this
+static const qreal DecelerationTime = 0.325;
+
+// a flicked wheel slower than this many steps per second stops
+static const qreal MinimumVelocity = 2;
+
+// a release later than this many milliseconds after the last move does not
+// flick the wheel
+static const int FlickTimeout = 50;
 
 /*!
 
@@ -52,6 +71,12 @@
 
     \sa skin(), setSkin()
 
+    The wheel is turned by dragging, by flicking and with the mouse wheel.
+    A fast drag moves more steps per pixel, and a flick keeps the wheel
+    spinning until it decelerates or reaches the end of the range. Wheel
+    and touchpad deltas are accumulated with their full resolution. All
+    input only collects steps, which are applied once per display refresh.
+
 
     No Signals defined. \n
 
@@ -85,6 +110,9 @@ void QtScrollWheel::init()
 {
     setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     m_currentIndex = 0;
+    m_pendingSteps = 0;
+    m_velocity = 0;
+    m_dragSpeed = 0;
 }
 
 /*!
@@ -136,24 +164,38 @@ QString QtScrollWheel::skin() const
 /*!
     \overload
     \internal
-    Overloaded mouse move event. Calculate new position of graphic.
+    Overloaded mouse move event. Collects the steps of the drag, a fast drag
+    moves more steps per pixel.
 */
 void QtScrollWheel::mouseMoveEvent(QMouseEvent* event)
 {
-    int diff = event->pos().y() - m_lastMousePosition.y();
-    if (qAbs(diff) > QApplication::startDragDistance()) {
-        changeValue((diff > 0) ? -1 : 1);
-        m_lastMousePosition = event->pos();
-    }
+    if (!m_dragClock.isValid())
+        return;
+
+    // moving up increases the value
+    const int diff = m_lastMousePosition.y() - event->pos().y();
+    m_lastMousePosition = event->pos();
+
+    const qint64 elapsed = qMax(qint64(1), m_dragClock.restart());
+    m_dragSpeed = 0.7 * diff / elapsed + 0.3 * m_dragSpeed;
+
+    m_pendingSteps += diff * acceleration(m_dragSpeed) / QApplication::startDragDistance();
+    scheduleFrame();
 }
 
 /*!
     \overload
     \internal
-    Overloaded mouse press event. Save last mouse position.
+    Overloaded mouse press event. Save last mouse position and stop a
+    flicked wheel.
 */
 void QtScrollWheel::mousePressEvent(QMouseEvent* event)
 {
+    m_pendingSteps = 0;
+    m_velocity = 0;
+    m_dragSpeed = 0;
+    m_dragClock.start();
+
     // remember mouse position for mouse move event
     m_lastMousePosition = event->pos();
     QAbstractSlider::mousePressEvent(event);
@@ -162,12 +204,120 @@ void QtScrollWheel::mousePressEvent(QMouseEvent* event)
 /*!
     \overload
     \internal
-    Overloaded wheel event. Change position of wheel over mouse wheel.
+    Overloaded mouse release event. Flicks the wheel if the pointer was
+    still moving.
+*/
+void QtScrollWheel::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (m_dragClock.isValid() && m_dragClock.elapsed() < FlickTimeout) {
+        const qreal velocity = m_dragSpeed * 1000 * acceleration(m_dragSpeed) / QApplication::startDragDistance();
+        if (qAbs(velocity) >= MinimumVelocity) {
+            m_velocity = velocity;
+            scheduleFrame();
+        }
+    }
+
+    m_dragClock.invalidate();
+    QAbstractSlider::mouseReleaseEvent(event);
+}
+
+/*!
+    \overload
+    \internal
+    Overloaded wheel event. Collects the steps of the mouse wheel or the
+    touchpad.
 */
 void QtScrollWheel::wheelEvent(QWheelEvent* event)
 {
-    const int diff = QApplication::wheelScrollLines();
-    changeValue(event->delta() > 0 ? diff : -diff);
+    // touchpads report pixels, mouse wheels eighths of a degree with 120
+    // per notch; high resolution wheels send fractions of a notch, which
+    // add up until they make a step
+    const QPoint pixels = event->pixelDelta();
+    if (!pixels.isNull())
+        m_pendingSteps += qreal(pixels.y()) / QApplication::startDragDistance();
+    else
+        m_pendingSteps += event->angleDelta().y() * QApplication::wheelScrollLines() / qreal(120);
+
+    event->accept();
+    scheduleFrame();
+}
+
+/*!
+    \internal
+    Returns how many times more steps per pixel a drag with \a speed in
+    pixels per millisecond moves.
+*/
+qreal QtScrollWheel::acceleration(qreal speed) const
+{
+    const qreal factor = speed / AccelerationSpeed;
+    return qMin(MaxAcceleration, 1 + factor * factor);
+}
+
+/*!
+    \internal
+    Starts the frame timer with the refresh rate of the screen the widget is
+    shown on, if it does not run yet.
+*/
+void QtScrollWheel::scheduleFrame()
+{
+    if (m_frameTimer.isActive())
+        return;
+
+    // the window has no native handle before it is shown
+    const QWindow *handle = window()->windowHandle();
+    const QScreen *screen = handle ? handle->screen() : QGuiApplication::primaryScreen();
+    const qreal rate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : qreal(60);
+    m_frameClock.start();
+    m_frameTimer.start(qMax(1, qRound(1000 / rate)), Qt::PreciseTimer, this);
+}
+
+/*!
+    \overload
+    \internal
+    Applies the whole pending steps and decelerates a flicked wheel, once
+    per display refresh.
+*/
+void QtScrollWheel::timerEvent(QTimerEvent* event)
+{
+    if (event->timerId() != m_frameTimer.timerId()) {
+        QAbstractSlider::timerEvent(event);
+        return;
+    }
+
+    // a late frame does not make the wheel jump
+    const qreal dt = qMin(qreal(0.1), m_frameClock.restart() / qreal(1000));
+
+    bool stopped = false;
+    if (m_velocity != 0) {
+        // exponential deceleration, integrated exactly over the frame
+        const qreal decay = qExp(-dt / DecelerationTime);
+        m_pendingSteps += m_velocity * DecelerationTime * (1 - decay);
+        m_velocity *= decay;
+        if (qAbs(m_velocity) < MinimumVelocity) {
+            m_velocity = 0;
+            stopped = true;
+        }
+    }
+
+    const int steps = int(m_pendingSteps);
+    m_pendingSteps -= steps;
+
+    // a flick does not leave a fraction of a step behind
+    if (stopped)
+        m_pendingSteps = 0;
+
+    if (steps != 0) {
+        changeValue(steps);
+
+        // the wheel stops at the ends of the range
+        if (value() == (steps < 0 ? minimum() : maximum())) {
+            m_velocity = 0;
+            m_pendingSteps = 0;
+        }
+    }
+
+    if (m_velocity == 0)
+        m_frameTimer.stop();
 }
 
 /*!
@@ -10,6 +10,8 @@
 #define QT_SCROLL_WHEEL_H
 
 #include <QAbstractSlider>
+#include <QBasicTimer>
+#include <QElapsedTimer>
 #include "qtsvgpixmapcache.h"
           
 class QMouseEvent;
@@ -27,12 +29,16 @@ public:
 protected:
     virtual void mousePressEvent(QMouseEvent* event);
     virtual void mouseMoveEvent(QMouseEvent* event);
+    virtual void mouseReleaseEvent(QMouseEvent* event);
     virtual void wheelEvent(QWheelEvent* event);
     virtual void paintEvent(QPaintEvent* event);
+    virtual void timerEvent(QTimerEvent* event);
     virtual QSize sizeHint() const;
 
     void init();
     void changeValue(int delta);
+    void scheduleFrame();
+    qreal acceleration(qreal speed) const;
 
 private:
     /** loaded graphics **/
@@ -42,6 +48,18 @@ private:
     /** actual shown picture 0-2 **/
     int m_currentIndex;
     QPoint m_lastMousePosition;
+    /** steps of the wheel not applied yet, including fractions **/
+    qreal m_pendingSteps;
+    /** speed of a flicked wheel in steps per second **/
+    qreal m_velocity;
+    /** smoothed speed of the drag in pixels per millisecond **/
+    qreal m_dragSpeed;
+    /** time since the last mouse move, invalid if not dragging **/
+    QElapsedTimer m_dragClock;
+    /** time since the last frame **/
+    QElapsedTimer m_frameClock;
+    /** applies the pending steps with the display refresh **/
+    QBasicTimer m_frameTimer;
     /** actual skin name **/
     QString m_skin;
 };
@@ -0,0 +1,20 @@
+# Unit tests of the QtBasicGraph kernels, histories and annotations. The
+# project is built on its own and runs headless on the offscreen platform:
+#
+#   qmake && make
+#   ./qtbasicgraphtest
+
+TEMPLATE = app
+TARGET = qtbasicgraphtest
+
+QT += core \
+    gui \
+    widgets \
+    testlib
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+include(../../src/basicgraph/basicgraph.pri)
+
+SOURCES += qtbasicgraphtest.cpp
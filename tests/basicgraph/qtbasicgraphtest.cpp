@@ -0,0 +1,904 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Unit tests of the QtBasicGraph kernels, histories and annotations.
+#include "qtbasicgraphkernels.h"
+#include "qtbasicgraphhistory.h"
+#include "qtbasicgraphcompressedhistory.h"
+#include "qtbasicgraphannotations.h"
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+enum {
+    TailCount = 41,      // covers every tail of the 2, 4 and 8 wide vector loops
+    Width = 64,          // size of the images the raster kernels draw into
+    Height = 48,
+    Tolerance = 2,       // color channel difference allowed against QPainter
+    ChunkSize = 64,      // samples per compressed chunk
+    ColumnsSamples = 20123
+};
+
+const qreal Resolution = 0.001;
+const quint32 Background = 0xff284878;
+
+typedef QtBasicGraphAnnotations::Annotation Annotation;
+
+// deterministic pseudo random numbers, so a failure can be reproduced
+class Random
+{
+public:
+    explicit Random(quint32 seed = 1) : m_state(seed) {}
+
+    quint32 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    // uniform in [low, high)
+    qreal uniform(qreal low, qreal high)
+    {
+        return low + (high - low) * (next() / 4294967296.0);
+    }
+
+private:
+    quint32 m_state;
+};
+
+// relative comparison that also works for values around zero
+bool fuzzyEqual(qreal a, qreal b, qreal epsilon = 1e-12)
+{
+    return qAbs(a - b) <= epsilon * qMax(qreal(1), qMax(qAbs(a), qAbs(b)));
+}
+
+// equal including the sign of zero
+bool samePoint(const QPointF &a, const QPointF &b)
+{
+    return a.x() == b.x() && a.y() == b.y() && std::signbit(a.y()) == std::signbit(b.y());
+}
+
+QImage createImage(quint32 fill)
+{
+    QImage image(Width, Height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(fill);
+    return image;
+}
+
+quint32 *imageBits(QImage &image)
+{
+    return reinterpret_cast<quint32 *>(image.bits());
+}
+
+int imageStride(const QImage &image)
+{
+    return image.bytesPerLine() / 4;
+}
+
+quint32 pixelAt(const QImage &image, int x, int y)
+{
+    return reinterpret_cast<const quint32 *>(image.constScanLine(y))[x];
+}
+
+// the first pixel set in image that has no set pixel around it in other,
+// or (-1, -1) if all of them have one
+QPoint uncoveredPixel(const QImage &image, const QImage &other)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            if (!pixelAt(image, x, y))
+                continue;
+
+            bool covered = false;
+            for (int v = qMax(0, y - 1); v <= qMin(other.height() - 1, y + 1) && !covered; ++v) {
+                for (int u = qMax(0, x - 1); u <= qMin(other.width() - 1, x + 1) && !covered; ++u)
+                    covered = pixelAt(other, u, v) != 0;
+            }
+            if (!covered)
+                return QPoint(x, y);
+        }
+    }
+    return QPoint(-1, -1);
+}
+
+// the largest difference of a color channel between two images of the same size
+int channelDifference(const QImage &a, const QImage &b)
+{
+    int difference = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            const quint32 p = pixelAt(a, x, y);
+            const quint32 q = pixelAt(b, x, y);
+            for (int shift = 0; shift < 32; shift += 8)
+                difference = qMax(difference, qAbs(int((p >> shift) & 0xff) - int((q >> shift) & 0xff)));
+        }
+    }
+    return difference;
+}
+
+int crossing(const float *y, int count, float level, bool rising)
+{
+    for (int i = 1; i < count; ++i) {
+        if (rising ? (y[i - 1] < level && level <= y[i]) : (y[i - 1] > level && level >= y[i]))
+            return i;
+    }
+    return -1;
+}
+
+QtBasicGraphHistory *createHistory(int storage)
+{
+    if (storage == 0)
+        return new QtBasicGraphMemoryHistory;
+    return new QtBasicGraphCompressedHistory(Resolution, 256);
+}
+
+// samples for the compressed history: the x steps change by delta of
+// deltas at both ends of every bucket of the encoding, the y values are
+// constant, slowly changing, random bits, signed zeros, large and double
+// values that are rounded to float
+QVector<QPointF> gorillaPoints()
+{
+    const qint64 dods[] = { 0, 1, -1, 63, -64, 64, -65, 255, -256, 256, -257,
+                            2047, -2048, 2048, -2049, 1000000, -1000000 };
+    const int dodCount = int(sizeof(dods) / sizeof(dods[0]));
+
+    Random random(5);
+    QVector<QPointF> points;
+    qint64 ticks = 1000;
+    qint64 delta = 3000;
+
+    while (points.size() < 1000) {
+        for (int d = 0; d < 2 * dodCount; ++d) {
+            delta += (d % 2) ? -dods[d / 2] : dods[d / 2];
+            ticks += delta;
+
+            const int i = points.size();
+            qreal y;
+            switch (i % 200 / 40) {
+            case 0:
+                y = 1.5;
+                break;
+            case 1:
+                y = std::sin(i * 0.01);
+                break;
+            case 2: {
+                quint32 bits = random.next();
+                if (((bits >> 23) & 0xff) == 0xff)
+                    bits &= ~(quint32(1) << 23);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                y = value;
+                break;
+            }
+            case 3:
+                y = (i % 4 < 2) ? (i % 2 ? -0.0 : 0.0) : random.uniform(-1e30, 1e30);
+                break;
+            default:
+                y = random.uniform(-1, 1);
+                break;
+            }
+
+            // off the grid, the history rounds x to the resolution
+            points.append(QPointF((ticks + random.uniform(-0.4, 0.4)) * Resolution, y));
+        }
+    }
+    return points;
+}
+
+// the sample the compressed history returns for points[index]: compressed
+// samples are quantized, the uncompressed tail keeps the added values
+QPointF storedPoint(const QVector<QPointF> &points, int index, qint64 compressed)
+{
+    const QPointF &point = points.at(index);
+    if (index >= compressed)
+        return point;
+    return QPointF(qRound64(point.x() / Resolution) * Resolution, float(point.y()));
+}
+
+QString pointString(const QPointF &point)
+{
+    return QString::fromLatin1("(%1, %2)").arg(point.x(), 0, 'g', 17).arg(point.y(), 0, 'g', 9);
+}
+
+// the texts of the annotations in any order, sorted for comparison
+QStringList texts(const QVector<Annotation> &annotations)
+{
+    QStringList result;
+    foreach (const Annotation &annotation, annotations)
+        result.append(annotation.text);
+    result.sort();
+    return result;
+}
+
+QStringList overlapping(const QVector<Annotation> &annotations, qreal x0, qreal x1)
+{
+    QVector<Annotation> result;
+    foreach (const Annotation &annotation, annotations) {
+        if (annotation.start <= x1 && annotation.end >= x0)
+            result.append(annotation);
+    }
+    return texts(result);
+}
+
+} // namespace
+
+
+class QtBasicGraphTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void mapPoints();
+    void mapSamples();
+    void minMax();
+    void findCrossing();
+    void accumulate();
+    void mapIntensity();
+    void rasterizePolyline_data();
+    void rasterizePolyline();
+    void accumulateHits();
+    void fillColumns_data();
+    void fillColumns();
+    void blitSprite();
+    void historyColumns_data();
+    void historyColumns();
+    void historyLowerBound_data();
+    void historyLowerBound();
+    void compressedRoundTrip();
+    void compressedRandomAccess();
+    void compressedSize();
+    void annotationsFind();
+    void annotationsPurge();
+};
+
+/*
+    The vector paths and the scalar tails map points like the formula.
+*/
+void QtBasicGraphTest::mapPoints()
+{
+    Random random;
+    for (int count = 0; count <= TailCount; ++count) {
+        QVector<QPointF> points(count);
+        for (int i = 0; i < count; ++i)
+            points[i] = QPointF(random.uniform(-1e3, 1e3), random.uniform(-1, 1));
+
+        QVector<QPointF> out(count);
+        qtBasicGraphMapPoints(points.constData(), count, 12.5, -0.25, 0.8, -240, out.data());
+
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(fuzzyEqual(out.at(i).x(), (points.at(i).x() - 12.5) * 0.8));
+            QVERIFY(fuzzyEqual(out.at(i).y(), (points.at(i).y() + 0.25) * -240));
+        }
+    }
+}
+
+void QtBasicGraphTest::mapSamples()
+{
+    Random random;
+    for (int count = 0; count <= TailCount; ++count) {
+        QVector<qreal> x(count);
+        QVector<float> y(count);
+        for (int i = 0; i < count; ++i) {
+            x[i] = random.uniform(-1e3, 1e3);
+            y[i] = float(random.uniform(-1, 1));
+        }
+
+        QVector<QPointF> out(count);
+        qtBasicGraphMapSamples(y.constData(), count, 7.25, 0.5, -0.25, -240, out.data());
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(fuzzyEqual(out.at(i).x(), 7.25 + i * 0.5));
+            QVERIFY(fuzzyEqual(out.at(i).y(), (qreal(y.at(i)) + 0.25) * -240));
+        }
+
+        qtBasicGraphMapSamples(x.constData(), y.constData(), count, 12.5, -0.25, 0.8, -240, out.data());
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(fuzzyEqual(out.at(i).x(), (x.at(i) - 12.5) * 0.8));
+            QVERIFY(fuzzyEqual(out.at(i).y(), (qreal(y.at(i)) + 0.25) * -240));
+        }
+    }
+}
+
+void QtBasicGraphTest::minMax()
+{
+    Random random;
+    for (int count = 1; count <= TailCount; ++count) {
+        QVector<float> y(count);
+        QVector<QPointF> points(count);
+        for (int i = 0; i < count; ++i) {
+            y[i] = float(random.uniform(-100, 100));
+            points[i] = QPointF(i, y.at(i));
+        }
+
+        float min;
+        float max;
+        qtBasicGraphMinMax(y.constData(), count, &min, &max);
+        QCOMPARE(min, *std::min_element(y.constBegin(), y.constEnd()));
+        QCOMPARE(max, *std::max_element(y.constBegin(), y.constEnd()));
+
+        qreal pointsMin;
+        qreal pointsMax;
+        qtBasicGraphMinMax(points.constData(), count, &pointsMin, &pointsMax);
+        QCOMPARE(pointsMin, qreal(min));
+        QCOMPARE(pointsMax, qreal(max));
+    }
+}
+
+/*
+    Crossings at every position of the vector loops and the tails, rising
+    and falling, against the definition in qtbasicgraphkernels.h.
+*/
+void QtBasicGraphTest::findCrossing()
+{
+    const float levels[] = { -5.0f, 0.05f, 0.95f, 1.85f, 2.35f, 3.95f, 100.0f };
+
+    Random random;
+    for (int count = 0; count <= TailCount; ++count) {
+        for (int pass = 0; pass < 3; ++pass) {
+            // a ramp crosses every level once, random values cross often
+            QVector<float> y(count);
+            for (int i = 0; i < count; ++i)
+                y[i] = (pass < 2) ? (pass ? -0.1f : 0.1f) * i : float(random.uniform(0, 4));
+
+            QVector<QPointF> points(count);
+            for (int i = 0; i < count; ++i)
+                points[i] = QPointF(i, y.at(i));
+
+            for (int l = 0; l < int(sizeof(levels) / sizeof(levels[0])); ++l) {
+                for (int rising = 0; rising < 2; ++rising) {
+                    const float level = (pass == 1) ? -levels[l] : levels[l];
+                    const int expected = crossing(y.constData(), count, level, rising);
+                    QCOMPARE(qtBasicGraphFindCrossing(y.constData(), count, level, rising), expected);
+                    QCOMPARE(qtBasicGraphFindCrossing(points.constData(), count, level, rising), expected);
+                }
+            }
+        }
+    }
+}
+
+void QtBasicGraphTest::accumulate()
+{
+    Random random;
+    for (int count = 0; count <= TailCount; ++count) {
+        QVector<float> intensity(count);
+        QVector<float> hits(count);
+        for (int i = 0; i < count; ++i) {
+            intensity[i] = float(random.uniform(0, 50));
+            hits[i] = float(random.next() % 4);
+        }
+
+        QVector<float> accumulated = intensity;
+        qtBasicGraphAccumulate(accumulated.data(), hits.constData(), count, 0.9f);
+        QVector<float> decayed = intensity;
+        qtBasicGraphDecay(decayed.data(), count, 0.9f);
+
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(fuzzyEqual(accumulated.at(i), qreal(intensity.at(i)) * 0.9f + hits.at(i), 1e-6));
+            QVERIFY(fuzzyEqual(decayed.at(i), qreal(intensity.at(i)) * 0.9f, 1e-6));
+        }
+    }
+}
+
+/*
+    Intensities above the table are mapped to its last entry.
+*/
+void QtBasicGraphTest::mapIntensity()
+{
+    quint32 lut[256];
+    for (int i = 0; i < 256; ++i)
+        lut[i] = 0xff000000 | i;
+
+    Random random;
+    for (int count = 0; count <= TailCount; ++count) {
+        QVector<float> intensity(count);
+        for (int i = 0; i < count; ++i)
+            intensity[i] = float(random.uniform(0, 320));
+
+        QVector<quint32> out(count);
+        qtBasicGraphMapIntensity(intensity.constData(), count, 0.9f, lut, 256, out.data());
+
+        for (int i = 0; i < count; ++i)
+            QCOMPARE(out.at(i), lut[int(qMin(intensity.at(i) * 0.9f, 255.0f))]);
+    }
+}
+
+void QtBasicGraphTest::rasterizePolyline_data()
+{
+    QTest::addColumn<QPolygonF>("points");
+    QTest::addColumn<QPointF>("offset");
+
+    QPolygonF zigzag;
+    zigzag << QPointF(0, 0) << QPointF(10, 40) << QPointF(20, 5) << QPointF(30, 44)
+           << QPointF(40, 12) << QPointF(63, 47);
+
+    QTest::newRow("horizontal") << (QPolygonF() << QPointF(4, 10) << QPointF(60, 10)) << QPointF();
+    QTest::newRow("vertical") << (QPolygonF() << QPointF(20, 2) << QPointF(20, 45)) << QPointF();
+    QTest::newRow("diagonal") << (QPolygonF() << QPointF(2, 2) << QPointF(45, 45)) << QPointF();
+    QTest::newRow("shallow") << (QPolygonF() << QPointF(3, 5) << QPointF(60, 17)) << QPointF();
+    QTest::newRow("steep") << (QPolygonF() << QPointF(10, 2) << QPointF(17, 45)) << QPointF();
+    QTest::newRow("backwards") << (QPolygonF() << QPointF(60, 40) << QPointF(2, 3)) << QPointF();
+    QTest::newRow("zigzag") << zigzag << QPointF();
+    QTest::newRow("translated") << zigzag << QPointF(3, -2);
+    QTest::newRow("clipped") << (QPolygonF() << QPointF(-20, 10) << QPointF(80, 30)
+                                 << QPointF(30, -15) << QPointF(10, 70)) << QPointF();
+    QTest::newRow("outside") << (QPolygonF() << QPointF(-10, -10) << QPointF(-5, 60)) << QPointF();
+}
+
+/*
+    The Bresenham lines match the aliased cosmetic lines of QPainter up to
+    one pixel, and hit the vertices exactly.
+*/
+void QtBasicGraphTest::rasterizePolyline()
+{
+    QFETCH(QPolygonF, points);
+    QFETCH(QPointF, offset);
+
+    const quint32 color = 0xff2080c0;
+
+    QImage image = createImage(0);
+    qtBasicGraphRasterizePolyline(imageBits(image), imageStride(image), Width, Height,
+                                  points.constData(), points.size(), offset.x(), offset.y(), color);
+
+    QImage expected = createImage(0);
+    QPainter painter(&expected);
+    painter.setPen(QPen(QColor::fromRgba(color), 0));
+    painter.translate(offset);
+    painter.drawPolyline(points);
+    painter.end();
+
+    for (int y = 0; y < Height; ++y) {
+        for (int x = 0; x < Width; ++x) {
+            const quint32 pixel = pixelAt(image, x, y);
+            QVERIFY(pixel == 0 || pixel == color);
+        }
+    }
+
+    const QPoint missing = uncoveredPixel(expected, image);
+    QVERIFY2(missing.x() < 0, qPrintable(QString::fromLatin1("no line near (%1, %2)")
+                                         .arg(missing.x()).arg(missing.y())));
+    const QPoint extra = uncoveredPixel(image, expected);
+    QVERIFY2(extra.x() < 0, qPrintable(QString::fromLatin1("QPainter draws no line near (%1, %2)")
+                                       .arg(extra.x()).arg(extra.y())));
+
+    foreach (const QPointF &point, points) {
+        const QPoint p = (point + offset).toPoint();
+        if (p.x() >= 0 && p.x() < Width && p.y() >= 0 && p.y() < Height)
+            QCOMPARE(pixelAt(image, p.x(), p.y()), color);
+    }
+}
+
+/*
+    The hits are the pixels of the rasterized polyline, the vertices shared
+    by two lines are only hit once.
+*/
+void QtBasicGraphTest::accumulateHits()
+{
+    const QPointF points[] = { QPointF(5, 5), QPointF(20, 5), QPointF(20, 30),
+                               QPointF(3, 40), QPointF(-30, 20), QPointF(40, 10) };
+    const int count = int(sizeof(points) / sizeof(points[0]));
+
+    QVector<float> hits(Width * Height, 0);
+    qtBasicGraphAccumulateHits(hits.data(), Width, Height, points, count, 0, 0);
+
+    QImage image = createImage(0);
+    qtBasicGraphRasterizePolyline(imageBits(image), imageStride(image), Width, Height,
+                                  points, count, 0, 0, 0xffffffff);
+
+    // the last line crosses the others, its crossings are hit twice
+    int twice = 0;
+    for (int y = 0; y < Height; ++y) {
+        for (int x = 0; x < Width; ++x) {
+            const float hit = hits.at(y * Width + x);
+            QCOMPARE(hit > 0, pixelAt(image, x, y) != 0);
+            QVERIFY(hit <= 2);
+            if (hit == 2)
+                ++twice;
+        }
+    }
+    QVERIFY(twice > 0 && twice <= 4);
+
+    QCOMPARE(hits.at(5 * Width + 20), 1.0f);
+    QCOMPARE(hits.at(30 * Width + 20), 1.0f);
+    QCOMPARE(hits.at(40 * Width + 3), 1.0f);
+}
+
+void QtBasicGraphTest::fillColumns_data()
+{
+    QTest::addColumn<float>("base");
+    QTest::addColumn<uint>("color");
+
+    const uint translucent = qPremultiply(qRgba(200, 100, 50, 128));
+    const uint opaque = 0xff3060a0;
+
+    QTest::newRow("translucent, base inside") << 20.0f << translucent;
+    QTest::newRow("translucent, base above") << -5.0f << translucent;
+    QTest::newRow("translucent, base below") << 60.0f << translucent;
+    QTest::newRow("opaque, base inside") << 20.0f << opaque;
+    QTest::newRow("opaque, base above") << -5.0f << opaque;
+}
+
+/*
+    The column spans blend like rectangles filled by QPainter, including
+    spans that are clipped or completely outside of the image.
+*/
+void QtBasicGraphTest::fillColumns()
+{
+    QFETCH(float, base);
+    QFETCH(uint, color);
+
+    float top[Width];
+    float bottom[Width];
+    for (int x = 0; x < Width; ++x) {
+        if (x % 7 == 3) {
+            top[x] = 1;
+            bottom[x] = 0;
+        } else {
+            top[x] = float((x * 5) % 60 - 8);
+            bottom[x] = top[x] + x % 9;
+        }
+    }
+
+    QImage image = createImage(Background);
+    qtBasicGraphFillColumns(imageBits(image), imageStride(image), Width, Height, top, bottom, base, color);
+
+    QImage expected = createImage(Background);
+    QPainter painter(&expected);
+    for (int x = 0; x < Width; ++x) {
+        if (top[x] > bottom[x])
+            continue;
+        const int low = int(qMin(top[x], base));
+        const int high = int(qMax(bottom[x], base));
+        painter.fillRect(QRect(QPoint(x, low), QPoint(x, high)), QColor::fromRgba(qUnpremultiply(color)));
+    }
+    painter.end();
+
+    QVERIFY(channelDifference(image, expected) <= Tolerance);
+}
+
+/*
+    Sprites blend like images drawn by QPainter at their top left corner,
+    a sprite on the same pixel as the one before is not drawn again.
+*/
+void QtBasicGraphTest::blitSprite()
+{
+    enum { Size = 5 };
+
+    QImage spriteImage(Size, Size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < Size; ++y) {
+        for (int x = 0; x < Size; ++x) {
+            const int distance = (x - Size / 2) * (x - Size / 2) + (y - Size / 2) * (y - Size / 2);
+            const int alpha = qMax(0, 255 - 50 * distance);
+            spriteImage.setPixel(x, y, qPremultiply(qRgba(250, 120, 30, alpha)));
+        }
+    }
+    QVector<quint32> sprite(Size * Size);
+    for (int y = 0; y < Size; ++y) {
+        for (int x = 0; x < Size; ++x)
+            sprite[y * Size + x] = pixelAt(spriteImage, x, y);
+    }
+
+    QPolygonF points;
+    points << QPointF(10, 10) << QPointF(10, 10) << QPointF(11, 10) << QPointF(0, 0)
+           << QPointF(63, 47) << QPointF(-2, 20) << QPointF(30, -10) << QPointF(40, 25);
+
+    QImage image = createImage(Background);
+    qtBasicGraphBlitSprite(imageBits(image), imageStride(image), Width, Height, sprite.constData(), Size,
+                           points.constData(), points.size(), 0, 0);
+
+    QImage expected = createImage(Background);
+    QPainter painter(&expected);
+    for (int i = 0; i < points.size(); ++i) {
+        if (i > 0 && points.at(i) == points.at(i - 1))
+            continue;
+        painter.drawImage(points.at(i).toPoint() - QPoint(Size / 2, Size / 2), spriteImage);
+    }
+    painter.end();
+
+    QVERIFY(channelDifference(image, expected) <= Tolerance);
+}
+
+void QtBasicGraphTest::historyColumns_data()
+{
+    QTest::addColumn<int>("storage");
+
+    QTest::newRow("memory") << 0;
+    QTest::newRow("compressed") << 1;
+}
+
+/*
+    The columns taken from the pyramid match a scan of all samples, for
+    columns narrower than a sample, spanning many blocks, not aligned to
+    the blocks and outside of the samples.
+*/
+void QtBasicGraphTest::historyColumns()
+{
+    QFETCH(int, storage);
+
+    QScopedPointer<QtBasicGraphHistory> history(createHistory(storage));
+    Random random;
+    for (int i = 0; i < ColumnsSamples; ++i)
+        history->append(QPointF(i * 0.5 + (i % 3) * 0.1, std::sin(i * 0.01) + random.uniform(-0.5, 0.5)));
+
+    struct Query {
+        qreal x0;
+        qreal x1;
+        int count;
+    };
+    const Query queries[] = {
+        { 0, 10062, 1 },
+        { 0, 10062, 7 },
+        { 0, 10062, 800 },
+        { 0, 10062, 50000 },
+        { 123.45, 8765.4, 97 },
+        { 5000, 5000.25, 3 },
+        { -100, 50, 10 },
+        { 9000, 20000, 13 },
+        { 20000, 30000, 5 }
+    };
+
+    const qint64 n = history->count();
+    for (int q = 0; q < int(sizeof(queries) / sizeof(queries[0])); ++q) {
+        const Query &query = queries[q];
+        QVector<QtBasicGraphHistory::Column> columns(query.count);
+        history->columns(query.x0, query.x1, columns.data(), query.count);
+
+        const qreal dx = (query.x1 - query.x0) / query.count;
+        qint64 i = 0;
+        while (i < n && history->at(i).x() < query.x0)
+            ++i;
+
+        for (int c = 0; c < query.count; ++c) {
+            const qreal end = (c == query.count - 1) ? query.x1 : query.x0 + (c + 1) * dx;
+            const qint64 first = i;
+            float min = std::numeric_limits<float>::max();
+            float max = -std::numeric_limits<float>::max();
+            for (; i < n && history->at(i).x() < end; ++i) {
+                const float y = float(history->at(i).y());
+                min = qMin(min, y);
+                max = qMax(max, y);
+            }
+
+            const QtBasicGraphHistory::Column &column = columns.at(c);
+            QCOMPARE(column.count, i - first);
+            if (column.count > 0) {
+                QCOMPARE(column.first, float(history->at(first).y()));
+                QCOMPARE(column.last, float(history->at(i - 1).y()));
+                QCOMPARE(column.min, min);
+                QCOMPARE(column.max, max);
+            }
+        }
+    }
+}
+
+void QtBasicGraphTest::historyLowerBound_data()
+{
+    historyColumns_data();
+}
+
+void QtBasicGraphTest::historyLowerBound()
+{
+    QFETCH(int, storage);
+
+    QScopedPointer<QtBasicGraphHistory> history(createHistory(storage));
+    QCOMPARE(history->lowerBound(0), qint64(0));
+
+    for (int i = 0; i < 1000; ++i)
+        history->append(QPointF(i * 0.5, i));
+
+    QCOMPARE(history->lowerBound(-1), qint64(0));
+    QCOMPARE(history->lowerBound(1000), qint64(1000));
+    for (qint64 i = 0; i < history->count(); ++i) {
+        const qreal x = history->at(i).x();
+        QCOMPARE(history->lowerBound(x), i);
+        QCOMPARE(history->lowerBound(x + 0.25), i + 1);
+    }
+}
+
+/*
+    Every sample decodes to its quantized x value and its y value as float,
+    across all buckets of the x encoding and all kinds of y values.
+*/
+void QtBasicGraphTest::compressedRoundTrip()
+{
+    const QVector<QPointF> points = gorillaPoints();
+
+    QtBasicGraphCompressedHistory history(Resolution, ChunkSize);
+    foreach (const QPointF &point, points)
+        history.append(point);
+
+    QCOMPARE(history.count(), qint64(points.size()));
+    const qint64 compressed = qint64(history.chunkCount()) * ChunkSize;
+    QVERIFY(compressed > 0 && compressed < points.size());
+
+    for (int i = 0; i < points.size(); ++i) {
+        const QPointF point = history.at(i);
+        const QPointF expected = storedPoint(points, i, compressed);
+        QVERIFY2(samePoint(point, expected),
+                 qPrintable(QString::fromLatin1("sample %1 is %2 instead of %3")
+                            .arg(i).arg(pointString(point), pointString(expected))));
+    }
+
+    QVector<QPointF> read(points.size());
+    history.read(0, points.size(), read.data());
+    for (int i = 0; i < points.size(); ++i)
+        QVERIFY(samePoint(read.at(i), storedPoint(points, i, compressed)));
+}
+
+/*
+    Reads that jump between chunks, so the two decoded chunks are evicted
+    in every order, return the same samples as a sequential read.
+*/
+void QtBasicGraphTest::compressedRandomAccess()
+{
+    const QVector<QPointF> points = gorillaPoints();
+
+    QtBasicGraphCompressedHistory history(Resolution, ChunkSize);
+    foreach (const QPointF &point, points)
+        history.append(point);
+    const qint64 compressed = qint64(history.chunkCount()) * ChunkSize;
+
+    Random random(7);
+    QVector<QPointF> read(3 * ChunkSize);
+    for (int k = 0; k < 2000; ++k) {
+        const int i = int(random.next() % quint32(points.size()));
+        QVERIFY(samePoint(history.at(i), storedPoint(points, i, compressed)));
+
+        const int count = qMin(int(random.next() % quint32(read.size())) + 1, points.size() - i);
+        history.read(i, count, read.data());
+        for (int j = 0; j < count; ++j)
+            QVERIFY(samePoint(read.at(j), storedPoint(points, i + j, compressed)));
+    }
+}
+
+/*
+    A constant rate and value take a few bits per sample, clear() drops the
+    chunks.
+*/
+void QtBasicGraphTest::compressedSize()
+{
+    QtBasicGraphCompressedHistory history(Resolution, ChunkSize);
+    for (int i = 0; i < 16 * ChunkSize + ChunkSize / 2; ++i)
+        history.append(QPointF(i * Resolution, 1.0));
+
+    QCOMPARE(history.chunkCount(), 16);
+    QVERIFY(history.compressedSize() > 0);
+    QVERIFY(history.compressedSize() < qint64(16 * ChunkSize * sizeof(QPointF) / 16));
+
+    history.clear();
+    QCOMPARE(history.count(), qint64(0));
+    QCOMPARE(history.chunkCount(), 0);
+    QCOMPARE(history.compressedSize(), qint64(0));
+
+    history.append(QPointF(2, 3));
+    QCOMPARE(history.at(0), QPointF(2, 3));
+}
+
+/*
+    The interval tree finds the annotations overlapping or touching a range,
+    including appended ones that are not indexed yet.
+*/
+void QtBasicGraphTest::annotationsFind()
+{
+    QtBasicGraphAnnotations annotations;
+    QVector<Annotation> all;
+    QVector<Annotation> result;
+    Random random(3);
+
+    for (int round = 0; round < 4; ++round) {
+        // added out of order, a fifth of them are markers
+        for (int i = 0; i < 300; ++i) {
+            Annotation annotation;
+            annotation.start = random.uniform(0, 1000);
+            annotation.end = annotation.start + ((i % 5) ? random.uniform(0, 40) : 0);
+            annotation.text = QString::number(all.size());
+            annotations.add(annotation);
+            all.append(annotation);
+        }
+        QCOMPARE(annotations.count(), all.size());
+
+        for (int q = 0; q < 200; ++q) {
+            qreal x0 = random.uniform(-10, 1050);
+            qreal x1 = x0 + ((q % 4) ? random.uniform(0, 50) : 0);
+
+            // ranges touching an annotation at either end
+            const Annotation &touched = all.at(int(random.next() % quint32(all.size())));
+            if (q % 3 == 1)
+                x0 = touched.end;
+            else if (q % 3 == 2)
+                x1 = touched.start;
+            if (x1 < x0)
+                qSwap(x0, x1);
+
+            annotations.find(x0, x1, &result);
+            QCOMPARE(texts(result), overlapping(all, x0, x1));
+        }
+
+        // a few appended ones stay in the unindexed tail
+        for (int i = 0; i < 5; ++i) {
+            Annotation annotation;
+            annotation.start = annotation.end = random.uniform(0, 1000);
+            annotation.text = QString::number(all.size());
+            annotations.add(annotation);
+            all.append(annotation);
+        }
+        annotations.find(0, 1000, &result);
+        QCOMPARE(texts(result), overlapping(all, 0, 1000));
+    }
+}
+
+/*
+    Purging keeps every annotation that ends at or behind the left edge,
+    while the view scrolls over appended annotations.
+*/
+void QtBasicGraphTest::annotationsPurge()
+{
+    QtBasicGraphAnnotations annotations;
+    QVector<Annotation> all;
+    QVector<Annotation> result;
+    Random random(11);
+
+    qreal left = 0;
+    for (int step = 0; step < 200; ++step) {
+        for (int i = 0; i < 20; ++i) {
+            Annotation annotation;
+            annotation.start = left + 100 + random.uniform(0, 10);
+            annotation.end = annotation.start + ((i % 10) ? random.uniform(0, 5) : random.uniform(0, 300));
+            annotation.text = QString::number(all.size());
+            annotations.add(annotation);
+            all.append(annotation);
+        }
+
+        left += 10;
+        annotations.purge(left);
+
+        QVector<Annotation> kept;
+        foreach (const Annotation &annotation, all) {
+            if (annotation.end >= left)
+                kept.append(annotation);
+        }
+        all = kept;
+        QVERIFY(annotations.count() >= all.size());
+
+        annotations.find(left, left + 100, &result);
+        QCOMPARE(texts(result), overlapping(all, left, left + 100));
+        annotations.find(left + 50, left + 50, &result);
+        QCOMPARE(texts(result), overlapping(all, left + 50, left + 50));
+    }
+
+    // the ended annotations are removed once they are the larger part
+    QVERIFY(annotations.count() < 2 * all.size() + 100);
+
+    annotations.clear();
+    QCOMPARE(annotations.count(), 0);
+    annotations.find(-1e9, 1e9, &result);
+    QVERIFY(result.isEmpty());
+}
+
+int main(int argc, char *argv[])
+{
+    // headless by default, an explicit platform still wins
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    QtBasicGraphTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "qtbasicgraphtest.moc"
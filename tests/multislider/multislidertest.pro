@@ -0,0 +1,21 @@
+# Unit tests of the QtMultiSlider thresholds. The project is built on its
+# own and runs headless on the offscreen platform:
+#
+#   qmake && make
+#   ./qtmultislidertest
+
+TEMPLATE = app
+TARGET = qtmultislidertest
+
+QT += core \
+    gui \
+    widgets \
+    testlib
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+include(../../src/common/common.pri)
+include(../../src/multislider/multislider.pri)
+
+SOURCES += qtmultislidertest.cpp
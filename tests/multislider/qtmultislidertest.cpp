@@ -0,0 +1,229 @@
+/*
+ Embedded Widgets Demo
+ Copyright (c) 2008 Nokia Corporation and/or its subsidiary(-ies).*
+ Contact:  Qt Software Information (qt-info@nokia.com)**
+ This file may be used under the terms of the Embedded Widgets Demo License
+ Agreement.
+*/
+
+//Unit tests of the QtMultiSlider thresholds.
+#include "qtmultislider.h"
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QElapsedTimer>
+
+namespace {
+
+enum {
+    HoldTime = 200    // milliseconds
+};
+
+} // namespace
+
+
+class QtMultiSliderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void defaultLimits();
+    void upperLimit();
+    void lowerLimit();
+    void hysteresis();
+    void holdTime();
+    void holdDropsReturn();
+};
+
+/*
+    The default limits sit at the ends of the range, moving the upper one
+    into the range lets the value exceed it.
+*/
+void QtMultiSliderTest::defaultLimits()
+{
+    QtMultiSlider slider;
+    QCOMPARE(slider.thresholdCount(), 2);
+    QCOMPARE(slider.thresholdType(0), QtMultiSlider::LowerLimit);
+    QCOMPARE(slider.thresholdValue(0), 0);
+    QCOMPARE(slider.thresholdType(1), QtMultiSlider::UpperLimit);
+    QCOMPARE(slider.thresholdValue(1), 100);
+
+    QSignalSpy maximumSpy(&slider, SIGNAL(maximumExceeded(bool)));
+    slider.setValue(100);
+    QVERIFY(!slider.isThresholdExceeded(1));
+
+    slider.setMaximumRange(80);
+    QVERIFY(slider.isThresholdExceeded(1));
+    QCOMPARE(maximumSpy.count(), 1);
+    QCOMPARE(maximumSpy.at(0).at(0).toBool(), true);
+}
+
+/*
+    An upper limit is exceeded by values above it, not by the limit itself.
+*/
+void QtMultiSliderTest::upperLimit()
+{
+    QtMultiSlider slider;
+    slider.clearThresholds();
+    const int index = slider.addThreshold(50, QtMultiSlider::UpperLimit);
+
+    QSignalSpy spy(&slider, SIGNAL(thresholdExceeded(int,bool)));
+    QSignalSpy maximumSpy(&slider, SIGNAL(maximumExceeded(bool)));
+
+    slider.setValue(50);
+    QCOMPARE(spy.count(), 0);
+
+    slider.setValue(51);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), index);
+    QCOMPARE(spy.at(0).at(1).toBool(), true);
+    QCOMPARE(maximumSpy.count(), 1);
+
+    slider.setValue(60);
+    QCOMPARE(spy.count(), 1);
+
+    slider.setValue(20);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(1).toBool(), false);
+    QCOMPARE(maximumSpy.count(), 2);
+    QCOMPARE(maximumSpy.at(1).at(0).toBool(), false);
+}
+
+void QtMultiSliderTest::lowerLimit()
+{
+    QtMultiSlider slider;
+    slider.clearThresholds();
+    slider.setValue(50);
+    const int index = slider.addThreshold(30, QtMultiSlider::LowerLimit);
+
+    QSignalSpy spy(&slider, SIGNAL(thresholdExceeded(int,bool)));
+    QSignalSpy minimumSpy(&slider, SIGNAL(minimumExceeded(bool)));
+
+    slider.setValue(30);
+    QCOMPARE(spy.count(), 0);
+
+    slider.setValue(29);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), index);
+    QCOMPARE(spy.at(0).at(1).toBool(), true);
+    QCOMPARE(minimumSpy.count(), 1);
+
+    slider.setValue(31);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(1).toBool(), false);
+    QCOMPARE(minimumSpy.count(), 2);
+}
+
+/*
+    Once exceeded, a limit is only cleared when the value leaves the
+    hysteresis band behind it, and exceeded again only beyond the limit.
+*/
+void QtMultiSliderTest::hysteresis()
+{
+    QtMultiSlider slider;
+    slider.clearThresholds();
+    slider.setHysteresis(5);
+    slider.setValue(40);
+    const int lower = slider.addThreshold(30, QtMultiSlider::LowerLimit);
+    const int upper = slider.addThreshold(50, QtMultiSlider::UpperLimit);
+
+    QSignalSpy spy(&slider, SIGNAL(thresholdExceeded(int,bool)));
+
+    slider.setValue(51);
+    QVERIFY(slider.isThresholdExceeded(upper));
+    slider.setValue(47);
+    QVERIFY(slider.isThresholdExceeded(upper));
+    slider.setValue(46);
+    QVERIFY(slider.isThresholdExceeded(upper));
+    slider.setValue(45);
+    QVERIFY(!slider.isThresholdExceeded(upper));
+    slider.setValue(50);
+    QVERIFY(!slider.isThresholdExceeded(upper));
+    QCOMPARE(spy.count(), 2);
+
+    slider.setValue(29);
+    QVERIFY(slider.isThresholdExceeded(lower));
+    slider.setValue(34);
+    QVERIFY(slider.isThresholdExceeded(lower));
+    slider.setValue(35);
+    QVERIFY(!slider.isThresholdExceeded(lower));
+    slider.setValue(30);
+    QVERIFY(!slider.isThresholdExceeded(lower));
+    QCOMPARE(spy.count(), 4);
+
+    // a smaller band clears a limit the value already left
+    slider.setValue(51);
+    slider.setValue(47);
+    QVERIFY(slider.isThresholdExceeded(upper));
+    slider.setHysteresis(2);
+    QVERIFY(!slider.isThresholdExceeded(upper));
+    QCOMPARE(spy.count(), 6);
+}
+
+/*
+    A change within the hold time of the last one is delayed until the
+    hold time is over.
+*/
+void QtMultiSliderTest::holdTime()
+{
+    QtMultiSlider slider;
+    slider.clearThresholds();
+    slider.setHoldTime(HoldTime);
+    const int index = slider.addThreshold(50, QtMultiSlider::UpperLimit);
+
+    QSignalSpy spy(&slider, SIGNAL(thresholdExceeded(int,bool)));
+    QSignalSpy maximumSpy(&slider, SIGNAL(maximumExceeded(bool)));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    slider.setValue(60);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(slider.isThresholdExceeded(index));
+
+    slider.setValue(40);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(slider.isThresholdExceeded(index));
+    QCOMPARE(maximumSpy.count(), 1);
+
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(timer.elapsed() >= HoldTime - 10);
+    QCOMPARE(spy.at(1).at(1).toBool(), false);
+    QVERIFY(!slider.isThresholdExceeded(index));
+    QCOMPARE(maximumSpy.count(), 2);
+}
+
+/*
+    A change is dropped if the value returned before the hold time is over.
+*/
+void QtMultiSliderTest::holdDropsReturn()
+{
+    QtMultiSlider slider;
+    slider.clearThresholds();
+    slider.setHoldTime(HoldTime);
+    const int index = slider.addThreshold(50, QtMultiSlider::UpperLimit);
+
+    QSignalSpy spy(&slider, SIGNAL(thresholdExceeded(int,bool)));
+
+    slider.setValue(60);
+    slider.setValue(40);
+    slider.setValue(70);
+    QTest::qWait(2 * HoldTime);
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(slider.isThresholdExceeded(index));
+}
+
+int main(int argc, char *argv[])
+{
+    // headless by default, an explicit platform still wins
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    QtMultiSliderTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "qtmultislidertest.moc"